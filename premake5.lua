@@ -321,5 +321,17 @@ links {"common"}
 
 resincludedirs {"$(ProjectDir)src"}
 
+project "tests"
+kind "ConsoleApp"
+language "C++"
+
+files {"./src/tests/**.hpp", "./src/tests/**.cpp"}
+
+includedirs {"./src/tests", "./src/common", "%{prj.location}/src"}
+
+links {"common"}
+
+dependencies.imports()
+
 group "Dependencies"
 dependencies.projects()
@@ -96,7 +96,7 @@ namespace achievements
 
 			const auto path = get_achievements_path();
 			const auto str = std::string(reinterpret_cast<char*>(data), sizeof(achievement_file_t));
-			utils::io::write_file(path.generic_string(), str, false);
+			utils::io::write_file_atomic(path.generic_string(), str);
 		}
 
 		bool has_achievement(achievement_file_t* file, int id)
@@ -316,18 +316,13 @@ namespace achievements
 		std::lock_guard _0(file_mutex);
 		const auto path = get_achievements_path().generic_string();
 
-		if (!utils::io::file_exists(path))
+		const utils::io::mapped_file data{path};
+		if (!data.is_valid() || data.size() < sizeof(achievement_file_t))
 		{
 			return;
 		}
 
-		const auto data = utils::io::read_file(path);
-		if (data.size() < sizeof(achievement_file_t))
-		{
-			return;
-		}
-
-		std::memcpy(file, data.data(), std::min(data.size(), sizeof(achievement_file_t)));
+		std::memcpy(file, data.data(), sizeof(achievement_file_t));
 		if (file->signature != ACHIEVEMENT_FILE_SIGNATURE)
 		{
 			std::memset(file, 0, sizeof(achievement_file_t));
@@ -101,8 +101,8 @@ namespace config
 		try
 		{
 			const auto path = get_config_file_path();
-			const auto str = json.dump(4);
-			utils::io::write_file(path, str, false);
+			// Settings are often changed several times in a row, only the last state has to hit the disk
+			utils::io::write_file_deferred(path, json.dump(4));
 		}
 		catch (const std::exception& e)
 		{
@@ -113,20 +113,21 @@ namespace config
 	nlohmann::json read_config()
 	{
 		const auto path = get_config_file_path();
-		if (!utils::io::file_exists(path))
+		const auto pending = utils::io::get_deferred_write(path);
+		if (!pending.has_value() && !utils::io::file_exists(path))
 		{
 			return {};
 		}
 
 		try
 		{
-			const auto data = utils::io::read_file(path);
+			const auto data = pending.has_value() ? pending.value() : utils::io::read_file(path);
 			return nlohmann::json::parse(data);
 		}
 		catch (const std::exception& e)
 		{
 			console::error("Failed to parse config file: %s\n", e.what());
-			utils::io::write_file(path, "{}", false);
+			utils::io::write_file_deferred(path, "{}");
 		}
 
 		return {};
@@ -144,6 +145,11 @@ namespace config
 				utils::io::remove_file(OLD_CONFIG_FILE);
 			}
 		}
+
+		void pre_destroy() override
+		{
+			utils::io::flush_deferred_writes();
+		}
 	};
 }
 
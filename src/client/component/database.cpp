@@ -20,8 +20,9 @@ namespace database
 	{
 		struct bnet_file_handle_t
 		{
-			std::unique_ptr<std::ifstream> stream;
+			utils::io::positioned_file file;
 			uint64_t offset{};
+			uint64_t position{};
 			std::string path;
 		};
 
@@ -173,11 +174,8 @@ namespace database
 				console::info("[Database] Opening file %s\n", path.data());
 #endif
 
-				auto stream = std::make_unique<std::ifstream>();
-				stream->open(path, std::ios::binary);
-
 				bnet_file_handle_t bnet_handle{};
-				bnet_handle.stream = std::move(stream);
+				bnet_handle.file = utils::io::positioned_file{path};
 				bnet_handle.path = path;
 				bnet_file_handles[handle] = std::move(bnet_handle);
 				return handle;
@@ -200,7 +198,7 @@ namespace database
 			else
 			{
 				auto& handle_ = bnet_file_handles[handle];
-				if (!handle_.stream->is_open())
+				if (!handle_.file.is_open())
 				{
 					return game::FILESYSRESULT_ERROR;
 				}
@@ -208,20 +206,13 @@ namespace database
 				try
 				{
 					const auto start_pos = offset - handle_.offset;
-					handle_.stream->seekg(0, std::ios::end);
-					const auto end_pos = static_cast<uint64_t>(handle_.stream->tellg());
-					handle_.stream->seekg(start_pos);
-
-					const auto len = end_pos - start_pos;
-					const auto bytes_to_read = len <= size ? len : size;
-
-					const auto& res = handle_.stream->read(reinterpret_cast<char*>(dest), bytes_to_read);
-					if (res.bad())
+					const auto res = handle_.file.read(start_pos, dest, static_cast<size_t>(size));
+					if (!res.has_value())
 					{
 						return game::FILESYSRESULT_ERROR;
 					}
 
-					const auto bytes_read = static_cast<uint64_t>(res.gcount());
+					const auto bytes_read = static_cast<uint64_t>(res.value());
 					handle->bytes_read += bytes_read;
 					handle->last_read = bytes_read;
 
@@ -244,7 +235,7 @@ namespace database
 			else
 			{
 				auto& handle_ = bnet_file_handles[handle];
-				if (!handle_.stream->is_open())
+				if (!handle_.file.is_open())
 				{
 					return game::FILESYSRESULT_ERROR;
 				}
@@ -270,19 +261,7 @@ namespace database
 			}
 			else
 			{
-				auto& handle_ = bnet_file_handles[handle];
-				try
-				{
-					handle_.stream->seekg(0, std::ios::end);
-					const std::streamsize size = handle_.stream->tellg();
-					handle_.stream->seekg(0, std::ios::beg);
-					return static_cast<uint64_t>(size);
-				}
-				catch (const std::exception& e)
-				{
-					console::error("[Database] bnet_fs_size_stub: %s\n", e.what());
-					return 0;
-				}
+				return bnet_file_handles[handle].file.size();
 			}
 		}
 
@@ -350,15 +329,17 @@ namespace database
 			else
 			{
 				auto& handle_ = bnet_file_handles[handle_ptr];
-				if (!handle_.stream->is_open())
+				if (!handle_.file.is_open())
 				{
 					return 0;
 				}
 
 				try
 				{
-					const auto& res = handle_.stream->read(reinterpret_cast<char*>(dest), bytes);
-					return static_cast<uint64_t>(res.gcount());
+					const auto res = handle_.file.read(handle_.position, dest, static_cast<size_t>(bytes));
+					const auto bytes_read = static_cast<uint64_t>(res.value_or(0));
+					handle_.position += bytes_read;
+					return bytes_read;
 				}
 				catch (const std::exception& e)
 				{
@@ -378,21 +359,13 @@ namespace database
 			else
 			{
 				auto& handle_ = bnet_file_handles[handle_ptr];
-				if (!handle_.stream->is_open())
+				if (!handle_.file.is_open())
 				{
 					return false;
 				}
 
-				try
-				{
-					const auto& res = handle_.stream->seekg(pos);
-					return !(res.fail() || res.bad());
-				}
-				catch (const std::exception& e)
-				{
-					console::error("[Database] bink_io_seek_stub: %s\n", e.what());
-					return 0;
-				}
+				handle_.position = pos;
+				return true;
 			}
 		}
 
@@ -410,11 +383,11 @@ namespace database
 
 	void close_fastfile_handles()
 	{
-		for (const auto& handle : bnet_file_handles)
+		for (auto& handle : bnet_file_handles)
 		{
 			if (handle.second.path.ends_with(".ff"))
 			{
-				handle.second.stream->close();
+				handle.second.file.close();
 			}
 		}
 	}
@@ -12,6 +12,8 @@
 
 #include <exception/minidump.hpp>
 
+#include <zlib.h>
+
 #include <version.hpp>
 
 #include "game/dvars.hpp"
@@ -178,7 +180,9 @@ namespace exception
 			                                                 game::environment::get_real_mode(),
 			                                                 get_timestamp().data());
 
-			utils::compression::zip::archive zip_file{};
+			// Keep the crashing process responsive, dumps compress well even at the fastest level.
+			// The filter continues execution afterwards and doesn't hold the loader lock, so worker threads can be started
+			utils::compression::zip::archive zip_file{Z_BEST_SPEED};
 			zip_file.add("crash.dmp", create_minidump(exceptioninfo));
 			zip_file.add("info.txt", generate_crash_info(exceptioninfo));
 			zip_file.write(crash_name, "H2-Mod Crash Dump");
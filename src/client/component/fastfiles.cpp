@@ -5,6 +5,7 @@
 
 #include "command.hpp"
 #include "console.hpp"
+#include "filesystem.hpp"
 #include "mods.hpp"
 #include "fonts.hpp"
 #include "imagefiles.hpp"
@@ -23,6 +24,19 @@ namespace fastfiles
 		game::dvar_t* db_print_default_assets = nullptr;
 		game::dvar_t* db_print_loaded_assets = nullptr;
 
+		// Opening a zone just to check if it exists is expensive and happens for every
+		// (localized) zone variant on each level load, results are kept until the search paths or
+		// any file under them change (e.g. a zone being added to a folder the path index never looked in)
+		struct exists_cache_t
+		{
+			size_t generation{};
+			std::unordered_map<std::string, bool> entries;
+			size_t hits{};
+			size_t misses{};
+		};
+
+		utils::concurrency::container<exists_cache_t> exists_cache;
+
 		template <size_t Bits>
 		struct bit_array
 		{
@@ -609,10 +623,38 @@ namespace fastfiles
 	bool exists(const std::string& zone)
 	{
 		const auto is_localized = game::DB_IsLocalized(zone.data());
+		const auto folder = is_localized ? game::SF_ZONE_LOC : game::SF_ZONE;
+		const auto key = std::to_string(folder) + "/" + zone;
+		const auto generation = filesystem::get_generation();
+
+		const auto cached = exists_cache.access<std::optional<bool>>([&](exists_cache_t& cache)
+			-> std::optional<bool>
+		{
+			if (cache.generation != generation)
+			{
+				cache.generation = generation;
+				cache.entries.clear();
+			}
+
+			const auto entry = cache.entries.find(key);
+			if (entry == cache.entries.end())
+			{
+				++cache.misses;
+				return {};
+			}
+
+			++cache.hits;
+			return {entry->second};
+		});
+
+		if (cached.has_value())
+		{
+			return cached.value();
+		}
+
 		const auto db_fs = game::DB_FSInitialize();
 
-		auto handle = db_fs->vftbl->OpenFile(db_fs,
-			(is_localized ? game::SF_ZONE_LOC : game::SF_ZONE), utils::string::va("%s.ff", zone.data()));
+		auto handle = db_fs->vftbl->OpenFile(db_fs, folder, utils::string::va("%s.ff", zone.data()));
 		const auto _0 = gsl::finally([&]
 		{
 			if (handle != nullptr)
@@ -621,7 +663,17 @@ namespace fastfiles
 			}
 		});
 
-		return handle != nullptr;
+		const auto result = handle != nullptr;
+
+		exists_cache.access([&](exists_cache_t& cache)
+		{
+			if (cache.generation == generation)
+			{
+				cache.entries[key] = result;
+			}
+		});
+
+		return result;
 	}
 
 	void enum_assets(const game::XAssetType type, const std::function<void(game::XAssetHeader)>& callback, const bool includeOverride)
@@ -748,6 +800,15 @@ namespace fastfiles
 
 			load_xasset_header_hook.create(0x140400790, load_xasset_header_stub);
 
+			command::add("zoneExistsStats", []()
+			{
+				exists_cache.access([](exists_cache_t& cache)
+				{
+					console::info("Zone exists cache: %zu hits, %zu opens, %zu entries\n",
+						cache.hits, cache.misses, cache.entries.size());
+				});
+			});
+
 			command::add("loadzone", [](const command::params& params)
 			{
 				if (params.size() < 2)
@@ -12,6 +12,8 @@
 #include <utils/hook.hpp>
 #include <utils/flags.hpp>
 #include <utils/properties.hpp>
+#include <utils/string.hpp>
+#include <utils/concurrency.hpp>
 
 namespace filesystem
 {
@@ -19,10 +21,147 @@ namespace filesystem
 	{
 		bool initialized = false;
 
-		std::deque<std::filesystem::path>& get_search_paths_internal()
+		constexpr auto no_search_path = std::numeric_limits<size_t>::max();
+
+		struct index_entry
+		{
+			std::optional<std::string> path;
+			size_t search_path; // Position of the search path it was found in, no_search_path if missing
+		};
+
+		// Watch handles are only checked this often, lookups in between may miss the latest changes
+		constexpr auto change_poll_interval = 50ms;
+
+		// Maps relative paths to the file that wins across all search paths (or to nothing),
+		// so repeated lookups don't have to probe every search path on disk
+		struct path_index
+		{
+			std::deque<std::filesystem::path> search_paths;
+			std::unordered_map<std::string, index_entry> entries;
+			std::vector<std::pair<HANDLE, size_t>> change_notifications;
+			std::chrono::steady_clock::time_point last_poll;
+		};
+
+		utils::concurrency::container<path_index> index;
+		std::atomic<size_t> generation = 0;
+
+		std::string get_index_key(const std::string& path)
+		{
+			auto key = utils::string::to_lower(path);
+			std::replace(key.begin(), key.end(), '\\', '/');
+			return key;
+		}
+
+		void close_change_notifications(path_index& idx)
+		{
+			for (const auto& [handle, search_path] : idx.change_notifications)
+			{
+				FindCloseChangeNotification(handle);
+			}
+
+			idx.change_notifications.clear();
+		}
+
+		void rebuild_index(path_index& idx)
+		{
+			++generation;
+			idx.entries.clear();
+			close_change_notifications(idx);
+
+			for (size_t i = 0; i < idx.search_paths.size(); ++i)
+			{
+				std::error_code ec{};
+				if (!std::filesystem::is_directory(idx.search_paths[i], ec))
+				{
+					continue;
+				}
+
+				const auto handle = FindFirstChangeNotificationW(idx.search_paths[i].wstring().data(), TRUE,
+					FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME);
+				if (handle != INVALID_HANDLE_VALUE)
+				{
+					idx.change_notifications.emplace_back(handle, i);
+				}
+			}
+		}
+
+		// Called from the lookup path on any thread. The game root is a search path too, so saves and
+		// config writes fire here; only lookups that could resolve differently because of the changed path are dropped
+		void check_change_notifications(path_index& idx)
+		{
+			const auto now = std::chrono::steady_clock::now();
+			if (now - idx.last_poll < change_poll_interval)
+			{
+				return;
+			}
+
+			idx.last_poll = now;
+
+			auto first_changed = no_search_path;
+
+			for (const auto& [handle, search_path] : idx.change_notifications)
+			{
+				if (WaitForSingleObject(handle, 0) == WAIT_OBJECT_0)
+				{
+					first_changed = std::min(first_changed, search_path);
+					FindNextChangeNotification(handle);
+				}
+			}
+
+			if (first_changed == no_search_path)
+			{
+				return;
+			}
+
+			// Files found in a search path with higher priority still win
+			std::erase_if(idx.entries, [&](const auto& entry)
+			{
+				return entry.second.search_path >= first_changed;
+			});
+
+			// Other caches (e.g. zone existence) are keyed by the generation and may hold
+			// results for files the index never saw
+			++generation;
+		}
+
+		std::optional<std::string> resolve_path(const std::string& path)
+		{
+			const auto key = get_index_key(path);
+
+			return index.access<std::optional<std::string>>([&](path_index& idx)
+			{
+				check_change_notifications(idx);
+
+				const auto entry = idx.entries.find(key);
+				if (entry != idx.entries.end())
+				{
+					return entry->second.path;
+				}
+
+				index_entry result{{}, no_search_path};
+
+				for (size_t i = 0; i < idx.search_paths.size(); ++i)
+				{
+					const auto path_ = (idx.search_paths[i] / path).generic_string();
+					if (utils::io::file_exists(path_))
+					{
+						result = {path_, i};
+						break;
+					}
+				}
+
+				idx.entries[key] = result;
+				return result.path;
+			});
+		}
+
+		void invalidate_index()
 		{
-			static std::deque<std::filesystem::path> search_paths{};
-			return search_paths;
+			index.access([](path_index& idx)
+			{
+				++generation;
+				idx.entries.clear();
+			});
 		}
 
 		void fs_startup_stub(const char* name)
@@ -56,9 +195,9 @@ namespace filesystem
 			return paths;
 		}
 
-		bool can_insert_path(const std::filesystem::path& path)
+		bool can_insert_path(const path_index& idx, const std::filesystem::path& path)
 		{
-			const auto& paths = get_search_paths_internal();
+			const auto& paths = idx.search_paths;
 			return std::ranges::none_of(paths.cbegin(), paths.cend(), [path](const auto& elem)
 			{
 				return elem == path;
@@ -91,13 +230,10 @@ namespace filesystem
 
 	std::string read_file(const std::string& path)
 	{
-		for (const auto& search_path : get_search_paths_internal())
+		const auto real_path = resolve_path(path);
+		if (real_path.has_value())
 		{
-			const auto path_ = search_path / path;
-			if (utils::io::file_exists(path_.generic_string()))
-			{
-				return utils::io::read_file(path_.generic_string());
-			}
+			return utils::io::read_file(real_path.value());
 		}
 
 		return {};
@@ -105,50 +241,46 @@ namespace filesystem
 
 	bool read_file(const std::string& path, std::string* data, std::string* real_path)
 	{
-		for (const auto& search_path : get_search_paths_internal())
+		const auto path_ = resolve_path(path);
+		if (!path_.has_value() || !utils::io::read_file(path_.value(), data))
 		{
-			const auto path_ = search_path / path;
-			if (utils::io::read_file(path_.generic_string(), data))
-			{
-				if (real_path != nullptr)
-				{
-					*real_path = path_.generic_string();
-				}
+			return false;
+		}
 
-				return true;
-			}
+		if (real_path != nullptr)
+		{
+			*real_path = path_.value();
 		}
 
-		return false;
+		return true;
 	}
 
 	bool find_file(const std::string& path, std::string* real_path)
 	{
-		for (const auto& search_path : get_search_paths_internal())
+		const auto path_ = resolve_path(path);
+		if (!path_.has_value())
 		{
-			const auto path_ = search_path / path;
-			if (utils::io::file_exists(path_.generic_string()))
-			{
-				*real_path = path_.generic_string();
-				return true;
-			}
+			return false;
 		}
 
-		return false;
+		*real_path = path_.value();
+		return true;
 	}
 
 	bool exists(const std::string& path)
 	{
-		for (const auto& search_path : get_search_paths_internal())
-		{
-			const auto path_ = search_path / path;
-			if (utils::io::file_exists(path_.generic_string()))
-			{
-				return true;
-			}
-		}
+		return resolve_path(path).has_value();
+	}
 
-		return false;
+	size_t get_generation()
+	{
+		// Callers like the zone existence cache never resolve through the index,
+		// so pending change notifications have to be picked up here as well
+		return index.access<size_t>([](path_index& idx)
+		{
+			check_change_notifications(idx);
+			return generation.load();
+		});
 	}
 
 	void register_path(const std::filesystem::path& path)
@@ -159,14 +291,20 @@ namespace filesystem
 		}
 
 		const auto paths = get_paths(path);
-		for (const auto& path_ : paths)
+
+		index.access([&](path_index& idx)
 		{
-			if (can_insert_path(path_))
+			for (const auto& path_ : paths)
 			{
-				console::info("[FS] Registering path '%s'\n", path_.generic_string().data());
-				get_search_paths_internal().push_front(path_);
+				if (can_insert_path(idx, path_))
+				{
+					console::info("[FS] Registering path '%s'\n", path_.generic_string().data());
+					idx.search_paths.push_front(path_);
+				}
 			}
-		}
+
+			rebuild_index(idx);
+		});
 	}
 
 	void unregister_path(const std::filesystem::path& path)
@@ -177,47 +315,59 @@ namespace filesystem
 		}
 
 		const auto paths = get_paths(path);
-		for (const auto& path_ : paths)
+
+		index.access([&](path_index& idx)
 		{
-			auto& search_paths = get_search_paths_internal();
-			for (auto i = search_paths.begin(); i != search_paths.end();)
+			for (const auto& path_ : paths)
 			{
-				if (*i == path_)
-				{
-					console::info("[FS] Unregistering path '%s'\n", path_.generic_string().data());
-					i = search_paths.erase(i);
-				}
-				else
+				auto& search_paths = idx.search_paths;
+				for (auto i = search_paths.begin(); i != search_paths.end();)
 				{
-					++i;
+					if (*i == path_)
+					{
+						console::info("[FS] Unregistering path '%s'\n", path_.generic_string().data());
+						i = search_paths.erase(i);
+					}
+					else
+					{
+						++i;
+					}
 				}
 			}
-		}
+
+			rebuild_index(idx);
+		});
 	}
 
 	std::vector<std::string> get_search_paths()
 	{
-		std::vector<std::string> paths{};
-
-		for (const auto& path : get_search_paths_internal())
+		return index.access<std::vector<std::string>>([](const path_index& idx)
 		{
-			paths.push_back(path.generic_string());
-		}
+			std::vector<std::string> paths{};
 
-		return paths;
+			for (const auto& path : idx.search_paths)
+			{
+				paths.push_back(path.generic_string());
+			}
+
+			return paths;
+		});
 	}
 
 	std::vector<std::string> get_search_paths_rev()
 	{
-		std::vector<std::string> paths{};
-		const auto& search_paths = get_search_paths_internal();
-
-		for (auto i = search_paths.rbegin(); i != search_paths.rend(); ++i)
+		return index.access<std::vector<std::string>>([](const path_index& idx)
 		{
-			paths.push_back(i->generic_string());
-		}
+			std::vector<std::string> paths{};
+			const auto& search_paths = idx.search_paths;
+
+			for (auto i = search_paths.rbegin(); i != search_paths.rend(); ++i)
+			{
+				paths.push_back(i->generic_string());
+			}
 
-		return paths;
+			return paths;
+		});
 	}
 
 	void check_path(const std::filesystem::path& path)
@@ -261,7 +411,11 @@ namespace filesystem
 	bool safe_write_file(const std::string& file, const std::string& data, bool append)
 	{
 		const auto path = filesystem::get_safe_path(file);
-		return utils::io::write_file(path, data, append);
+		const auto result = utils::io::write_file(path, data, append);
+
+		// Don't rely on the change notification having been delivered yet
+		invalidate_index();
+		return result;
 	}
 
 	class component final : public component_interface
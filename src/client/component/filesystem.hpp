@@ -9,6 +9,10 @@ namespace filesystem
 	bool find_file(const std::string& path, std::string* real_path);
 	bool exists(const std::string& path);
 
+	// Changes whenever search paths are (un)registered or files in them are added, removed or renamed.
+	// Pending change notifications are checked on every call (throttled), not only when lookups happen
+	size_t get_generation();
+
 	void register_path(const std::filesystem::path& path);
 	void unregister_path(const std::filesystem::path& path);
 
@@ -0,0 +1,175 @@
+#include <std_include.hpp>
+
+#include "script_cache.hpp"
+
+#include <utils/cryptography.hpp>
+#include <utils/io.hpp>
+#include <utils/properties.hpp>
+#include <utils/string.hpp>
+
+#include <version.hpp>
+
+#define SCRIPT_CACHE_FILE_SIGNATURE 'CG2H' // H2GC (H2-MOD GSC Cache)
+#define SCRIPT_CACHE_VERSION 1
+
+namespace gsc::cache
+{
+	namespace
+	{
+#pragma pack(push, 1)
+		struct cache_file_header
+		{
+			std::uint32_t signature;
+			std::uint32_t version;
+			std::uint8_t key[20];
+			std::uint32_t bytecode_size;
+			std::uint32_t stack_size;
+		};
+#pragma pack(pop)
+
+		std::atomic<size_t> hits = 0;
+		std::atomic<size_t> misses = 0;
+
+		std::string get_cache_file(const std::string& real_name)
+		{
+			const auto name = utils::cryptography::sha1::compute(real_name, true) + ".bin";
+			return (utils::properties::get_appdata_path() / "cache/gsc" / name).generic_string();
+		}
+
+		std::string trim(const std::string_view text)
+		{
+			const auto start = text.find_first_not_of(" \t");
+			if (start == std::string_view::npos)
+			{
+				return {};
+			}
+
+			const auto end = text.find_last_not_of(" \t\r");
+			return std::string{text.substr(start, end - start + 1)};
+		}
+
+		// Collects the files named by #include and #inline directives. Inlined headers are
+		// pasted into the script, so their own dependencies are followed as well
+		void add_dependencies(const std::string& source, const read_file_t& read_file,
+			const get_asset_id_t& get_asset_id, std::unordered_set<std::string>& visited, std::string& key)
+		{
+			size_t line_start = 0;
+			while (line_start < source.size())
+			{
+				auto line_end = source.find('\n', line_start);
+				if (line_end == std::string::npos)
+				{
+					line_end = source.size();
+				}
+
+				const auto line = trim(std::string_view{source}.substr(line_start, line_end - line_start));
+				line_start = line_end + 1;
+
+				const auto is_include = line.starts_with("#include ") || line.starts_with("#include\t");
+				const auto is_inline = line.starts_with("#inline ") || line.starts_with("#inline\t");
+				if (!is_include && !is_inline)
+				{
+					continue;
+				}
+
+				const auto path_start = is_include ? sizeof("#include") : sizeof("#inline");
+				const auto path_end = std::min(line.find(';'), line.size());
+				const auto path = trim(std::string_view{line}.substr(path_start, path_end - path_start));
+
+				const auto name = utils::string::replace(path, "\\", "/") + (is_include ? ".gsc" : ".gsh");
+				if (!visited.emplace(name).second)
+				{
+					continue;
+				}
+
+				std::string data{};
+				const auto found = read_file(name, &data);
+
+				key.append(name);
+				key.push_back('\0');
+				key.append(found ? data : get_asset_id(name));
+				key.push_back('\0');
+
+				if (found && is_inline)
+				{
+					add_dependencies(data, read_file, get_asset_id, visited, key);
+				}
+			}
+		}
+	}
+
+	std::string compute_key(const std::string& real_name, const std::string& source, const bool developer,
+		const read_file_t& read_file, const get_asset_id_t& get_asset_id)
+	{
+		std::string key{};
+		key.append(VERSION);
+		key.push_back('\0');
+		key.append(developer ? "dev" : "prod");
+		key.push_back('\0');
+		key.append(real_name);
+		key.push_back('\0');
+		key.append(source);
+		key.push_back('\0');
+
+		std::unordered_set<std::string> visited{};
+		add_dependencies(source, read_file, get_asset_id, visited, key);
+
+		return utils::cryptography::sha1::compute(key);
+	}
+
+	std::optional<compiled_script> find(const std::string& real_name, const std::string& key)
+	{
+		const utils::io::mapped_file file{get_cache_file(real_name)};
+		const auto data = file.get_span();
+
+		if (!file.is_valid() || data.size() < sizeof(cache_file_header))
+		{
+			++misses;
+			return {};
+		}
+
+		const auto* header = reinterpret_cast<const cache_file_header*>(data.data());
+		if (header->signature != SCRIPT_CACHE_FILE_SIGNATURE
+			|| header->version != SCRIPT_CACHE_VERSION
+			|| key.size() != sizeof(header->key)
+			|| std::memcmp(header->key, key.data(), sizeof(header->key))
+			|| data.size() != sizeof(cache_file_header) + header->bytecode_size + header->stack_size)
+		{
+			++misses;
+			return {};
+		}
+
+		const auto* bytecode = data.data() + sizeof(cache_file_header);
+		const auto* stack = bytecode + header->bytecode_size;
+
+		compiled_script script{};
+		script.bytecode.assign(bytecode, bytecode + header->bytecode_size);
+		script.stack.assign(stack, stack + header->stack_size);
+
+		++hits;
+		return {std::move(script)};
+	}
+
+	void store(const std::string& real_name, const std::string& key, const compiled_script& script)
+	{
+		cache_file_header header{};
+		header.signature = SCRIPT_CACHE_FILE_SIGNATURE;
+		header.version = SCRIPT_CACHE_VERSION;
+		std::memcpy(header.key, key.data(), std::min(key.size(), sizeof(header.key)));
+		header.bytecode_size = static_cast<std::uint32_t>(script.bytecode.size());
+		header.stack_size = static_cast<std::uint32_t>(script.stack.size());
+
+		std::string buffer{};
+		buffer.reserve(sizeof(header) + script.bytecode.size() + script.stack.size());
+		buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+		buffer.append(script.bytecode.begin(), script.bytecode.end());
+		buffer.append(script.stack.begin(), script.stack.end());
+
+		utils::io::write_file_atomic(get_cache_file(real_name), buffer);
+	}
+
+	stats get_stats()
+	{
+		return {hits, misses};
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+namespace gsc::cache
+{
+	struct compiled_script
+	{
+		std::vector<std::uint8_t> bytecode;
+		std::vector<std::uint8_t> stack;
+	};
+
+	struct stats
+	{
+		size_t hits;
+		size_t misses;
+	};
+
+	using read_file_t = std::function<bool(const std::string& name, std::string* data)>;
+
+	// Identifies an include that only exists as a compiled game asset
+	using get_asset_id_t = std::function<std::string(const std::string& name)>;
+
+	// Hashes everything the compiled output depends on: the client build, the build mode,
+	// the source itself and the files it includes or inlines
+	std::string compute_key(const std::string& real_name, const std::string& source, bool developer,
+		const read_file_t& read_file, const get_asset_id_t& get_asset_id);
+
+	std::optional<compiled_script> find(const std::string& real_name, const std::string& key);
+	void store(const std::string& real_name, const std::string& key, const compiled_script& script);
+
+	stats get_stats();
+}
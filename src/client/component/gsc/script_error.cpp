@@ -295,19 +295,7 @@ namespace gsc
 
 	std::optional<std::pair<std::string, std::string>> find_function(const char* pos)
 	{
-		for (const auto& file : scripting::script_function_table_sort)
-		{
-			for (auto i = file.second.begin(); i != file.second.end() && std::next(i) != file.second.end(); ++i)
-			{
-				const auto next = std::next(i);
-				if (pos >= i->second && pos < next->second)
-				{
-					return {std::make_pair(i->first, file.first)};
-				}
-			}
-		}
-
-		return {};
+		return scripting::find_function_by_pos(pos);
 	}
 
 	class error final : public component_interface
@@ -9,10 +9,14 @@
 #include "component/scripting.hpp"
 #include "component/fastfiles.hpp"
 #include "component/memory.hpp"
+#include "component/command.hpp"
+#include "component/scheduler.hpp"
 
 #include "script_loading.hpp"
+#include "script_cache.hpp"
 
 #include <utils/compression.hpp>
+#include <utils/cryptography.hpp>
 #include <utils/hook.hpp>
 #include <utils/io.hpp>
 #include <utils/memory.hpp>
@@ -30,6 +34,23 @@ namespace gsc
 		std::unordered_map<std::string, game::ScriptFile*> loaded_scripts;
 		utils::memory::allocator script_allocator;
 
+		// Output of the parallel pre-pass, keyed by script name along with the cache key it was built for
+		std::unordered_map<std::string, cache::compiled_script> prebuilt_scripts;
+
+		using include_data = std::pair<xsk::gsc::buffer, std::vector<std::uint8_t>>;
+
+		constexpr std::pair<std::string_view, std::uint16_t> extra_functions[] =
+		{
+			{"isusinghdr", 0x242},
+			{"tablegetrowcount", 0x2A6},
+			{"setshaderconstant", 0x2F1},
+		};
+
+		constexpr std::pair<std::string_view, std::uint16_t> extra_methods[] =
+		{
+			{"setclutforplayer", 0x849F},
+		};
+
 		struct
 		{
 			char* buf = nullptr;
@@ -67,6 +88,7 @@ namespace gsc
 			main_handles.clear();
 			init_handles.clear();
 			loaded_scripts.clear();
+			prebuilt_scripts.clear();
 			script_allocator.clear();
 			free_script_memory();
 		}
@@ -97,6 +119,39 @@ namespace gsc
 			return false;
 		}
 
+		std::string get_script_file_name(const std::string& name)
+		{
+			const auto id = gsc_ctx->token_id(name);
+			if (!id)
+			{
+				return name;
+			}
+
+			return std::to_string(id);
+		}
+
+		// Includes served from a fastfile have no source, their compiled output stands in for it in cache keys
+		std::string get_script_asset_id(const std::string& file_name)
+		{
+			const auto include_name = file_name.ends_with(".gsc") ? file_name.substr(0, file_name.size() - 4) : file_name;
+			const auto name = get_script_file_name(include_name);
+			if (!game::DB_XAssetExists(game::ASSET_TYPE_SCRIPTFILE, name.data()))
+			{
+				return "<missing>";
+			}
+
+			const auto* script_file = game::DB_FindXAssetHeader(game::ASSET_TYPE_SCRIPTFILE, name.data(), false).scriptfile;
+			if (!script_file)
+			{
+				return "<missing>";
+			}
+
+			const auto bytecode_hash = utils::cryptography::sha1::compute(
+				reinterpret_cast<const std::uint8_t*>(script_file->bytecode), static_cast<size_t>(script_file->bytecodeLen), true);
+
+			return std::format("<asset {} {} {}>", script_file->len, script_file->compressedLen, bytecode_hash);
+		}
+
 		game::ScriptFile* load_custom_script(const char* file_name, const std::string& real_name)
 		{
 			if (const auto itr = loaded_scripts.find(file_name); itr != loaded_scripts.end())
@@ -106,35 +161,61 @@ namespace gsc
 
 			try
 			{
-				auto& compiler = gsc_ctx->compiler();
-				auto& assembler = gsc_ctx->assembler();
+				std::optional<cache::compiled_script> script{};
+
+				// Prebuilt scripts were keyed during the same load, their sources can't have changed since
+				if (const auto prebuilt = prebuilt_scripts.find(real_name); prebuilt != prebuilt_scripts.end())
+				{
+					script.emplace(std::move(prebuilt->second));
+					prebuilt_scripts.erase(prebuilt);
+				}
 
 				std::string source_buffer{};
-				if (!read_raw_script_file(real_name + ".gsc", &source_buffer))
+				if (!script.has_value() && !read_raw_script_file(real_name + ".gsc", &source_buffer))
 				{
 					return nullptr;
 				}
 
-				std::vector<std::uint8_t> data;
-				data.assign(source_buffer.begin(), source_buffer.end());
+				std::string key{};
+				if (!script.has_value())
+				{
+					key = cache::compute_key(real_name, source_buffer, developer_script->current.enabled,
+						read_raw_script_file, get_script_asset_id);
+					script = cache::find(real_name, key);
+				}
+
+				if (!script.has_value())
+				{
+					auto& compiler = gsc_ctx->compiler();
+					auto& assembler = gsc_ctx->assembler();
+
+					std::vector<std::uint8_t> data;
+					data.assign(source_buffer.begin(), source_buffer.end());
+
+					const auto assembly_ptr = compiler.compile(real_name, data);
+					const auto output_script = assembler.assemble(*assembly_ptr);
 
-				const auto assembly_ptr = compiler.compile(real_name, data);
-				const auto output_script = assembler.assemble(*assembly_ptr);
+					script.emplace();
+					script->bytecode.assign(output_script.first.data, output_script.first.data + output_script.first.size);
+					script->stack.assign(output_script.second.data, output_script.second.data + output_script.second.size);
+
+					cache::store(real_name, key, script.value());
+				}
 
 				const auto script_file_ptr = static_cast<game::ScriptFile*>(script_allocator.allocate(sizeof(game::ScriptFile)));
 				script_file_ptr->name = file_name;
 
-				script_file_ptr->len = static_cast<int>(output_script.second.size);
-				script_file_ptr->bytecodeLen = static_cast<int>(output_script.first.size);
+				script_file_ptr->len = static_cast<int>(script->stack.size());
+				script_file_ptr->bytecodeLen = static_cast<int>(script->bytecode.size());
 
-				const auto stack_size = static_cast<std::uint32_t>(output_script.second.size + 1);
-				const auto byte_code_size = static_cast<std::uint32_t>(output_script.first.size + 1);
+				const auto stack_size = static_cast<std::uint32_t>(script->stack.size() + 1);
+				const auto byte_code_size = static_cast<std::uint32_t>(script->bytecode.size() + 1);
 
 				script_file_ptr->buffer = static_cast<char*>(script_allocator.allocate(stack_size));
-				std::memcpy(const_cast<char*>(script_file_ptr->buffer), output_script.second.data, output_script.second.size);
+				std::memcpy(const_cast<char*>(script_file_ptr->buffer), script->stack.data(), script->stack.size());
 
 				script_file_ptr->bytecode = allocate_buffer(byte_code_size);
-				std::memcpy(script_file_ptr->bytecode, output_script.first.data, output_script.first.size);
+				std::memcpy(script_file_ptr->bytecode, script->bytecode.data(), script->bytecode.size());
 
 				script_file_ptr->compressedLen = 0;
 
@@ -161,17 +242,6 @@ namespace gsc
 			return name + ".gsc";
 		}
 
-		std::string get_script_file_name(const std::string& name)
-		{
-			const auto id = gsc_ctx->token_id(name);
-			if (!id)
-			{
-				return name;
-			}
-
-			return std::to_string(id);
-		}
-
 		auto read_compiled_script_file(const std::string& name, const std::string& real_name)
 		{
 			const auto* script_file = game::DB_FindXAssetHeader(game::ASSET_TYPE_SCRIPTFILE, name.data(), false).scriptfile;
@@ -180,13 +250,13 @@ namespace gsc
 				throw std::runtime_error(std::format("Could not load scriptfile '{}'", real_name));
 			}
 
-			const auto len = script_file->compressedLen;
-			const std::string stack{script_file->buffer, static_cast<std::uint32_t>(len)};
-
-			const auto decompressed_stack = utils::compression::zlib::decompress(stack);
+			const std::span stack
+			{
+				reinterpret_cast<const std::uint8_t*>(script_file->buffer),
+				static_cast<std::size_t>(script_file->compressedLen)
+			};
 
-			std::vector<std::uint8_t> stack_data;
-			stack_data.assign(decompressed_stack.begin(), decompressed_stack.end());
+			auto stack_data = utils::compression::zlib::decompress(stack, static_cast<std::size_t>(script_file->len));
 
 			const xsk::gsc::buffer buffer
 			{
@@ -197,6 +267,202 @@ namespace gsc
 			return std::make_pair(buffer, stack_data);
 		}
 
+		include_data load_include(const std::string& include_name)
+		{
+			const auto real_name = get_raw_script_file_name(include_name);
+
+			std::string file_buffer;
+			if (!read_raw_script_file(real_name, &file_buffer) || file_buffer.empty())
+			{
+				const auto name = get_script_file_name(include_name);
+				if (game::DB_XAssetExists(game::ASSET_TYPE_SCRIPTFILE, name.data()))
+				{
+					return read_compiled_script_file(name, real_name);
+				}
+
+				throw std::runtime_error(std::format("Could not load gsc file '{}'", real_name));
+			}
+
+			std::vector<std::uint8_t> script_data;
+			script_data.assign(file_buffer.begin(), file_buffer.end());
+
+			return {{}, script_data};
+		}
+
+		xsk::gsc::build get_build_mode()
+		{
+			return developer_script->current.enabled
+				? xsk::gsc::build::dev
+				: xsk::gsc::build::prod;
+		}
+
+		std::unique_ptr<xsk::gsc::h2::context> create_context()
+		{
+			auto ctx = std::make_unique<xsk::gsc::h2::context>();
+
+			auto& func_map = ctx->func_map();
+			auto& meth_map = ctx->meth_map();
+			auto func_map_ = reinterpret_cast<std::unordered_map<std::string_view, uint16_t>*>(
+				reinterpret_cast<size_t>(&func_map));
+			auto meth_map_ = reinterpret_cast<std::unordered_map<std::string_view, uint16_t>*>(
+				reinterpret_cast<size_t>(&meth_map));
+
+			func_map_->insert(std::begin(extra_functions), std::end(extra_functions));
+			meth_map_->insert(std::begin(extra_methods), std::end(extra_methods));
+
+			return ctx;
+		}
+
+		// Compiles the scripts that aren't cached yet on the worker pool, every worker with its own compiler.
+		// Includes can come from game assets, so their reads are handed back to this thread, which serves them
+		// until all workers are done. Scripts that fail here are compiled again by load_custom_script.
+		void precompile_scripts(const std::vector<std::string>& names)
+		{
+			struct pending_script
+			{
+				std::string name;
+				std::string source;
+				std::string key;
+				std::optional<cache::compiled_script> result;
+			};
+
+			const auto developer = developer_script->current.enabled;
+			std::vector<pending_script> pending;
+
+			// Scripts can be found both as rawfile assets and in the search paths
+			std::unordered_set<std::string> unique_names{};
+
+			for (const auto& name : names)
+			{
+				std::string source{};
+				if (!unique_names.emplace(name).second || prebuilt_scripts.contains(name)
+					|| !read_raw_script_file(name + ".gsc", &source))
+				{
+					continue;
+				}
+
+				auto key = cache::compute_key(name, source, developer, read_raw_script_file, get_script_asset_id);
+				if (auto cached = cache::find(name, key); cached.has_value())
+				{
+					prebuilt_scripts[name] = std::move(cached.value());
+					continue;
+				}
+
+				pending.emplace_back(pending_script{name, std::move(source), std::move(key), {}});
+			}
+
+			if (pending.empty())
+			{
+				return;
+			}
+
+			std::mutex mutex;
+			std::condition_variable condition;
+			std::deque<std::pair<std::string, std::promise<include_data>>> requests;
+			std::atomic<size_t> next_script = 0;
+
+			const auto build_mode = get_build_mode();
+			const auto request_include = [&](const std::string& include_name) -> include_data
+			{
+				std::promise<include_data> promise;
+				auto future = promise.get_future();
+
+				{
+					std::lock_guard _(mutex);
+					requests.emplace_back(include_name, std::move(promise));
+				}
+
+				condition.notify_all();
+				return future.get();
+			};
+
+			const auto worker_count = std::min(pending.size(), size_t(std::max(1u, std::thread::hardware_concurrency())));
+			auto running_workers = worker_count;
+
+			for (size_t i = 0; i < worker_count; ++i)
+			{
+				scheduler::post([&]()
+				{
+					const auto _ = gsl::finally([&]()
+					{
+						// Notify under the lock, the state lives on the waiting thread's stack
+						std::lock_guard lock(mutex);
+						--running_workers;
+						condition.notify_all();
+					});
+
+					const auto ctx = create_context();
+					ctx->init(build_mode, request_include);
+
+					for (auto index = next_script++; index < pending.size(); index = next_script++)
+					{
+						auto& script = pending[index];
+
+						try
+						{
+							std::vector<std::uint8_t> data;
+							data.assign(script.source.begin(), script.source.end());
+
+							const auto assembly_ptr = ctx->compiler().compile(script.name, data);
+							const auto output_script = ctx->assembler().assemble(*assembly_ptr);
+
+							script.result.emplace();
+							script.result->bytecode.assign(output_script.first.data,
+								output_script.first.data + output_script.first.size);
+							script.result->stack.assign(output_script.second.data,
+								output_script.second.data + output_script.second.size);
+						}
+						catch (const std::exception&)
+						{
+							// The game thread reports the error when it compiles the script itself
+						}
+					}
+
+					ctx->cleanup();
+				});
+			}
+
+			std::unique_lock lock(mutex);
+			while (true)
+			{
+				condition.wait(lock, [&]()
+				{
+					return running_workers == 0 || !requests.empty();
+				});
+
+				if (requests.empty())
+				{
+					break;
+				}
+
+				auto request = std::move(requests.front());
+				requests.pop_front();
+				lock.unlock();
+
+				try
+				{
+					request.second.set_value(load_include(request.first));
+				}
+				catch (...)
+				{
+					request.second.set_exception(std::current_exception());
+				}
+
+				lock.lock();
+			}
+
+			lock.unlock();
+
+			for (auto& script : pending)
+			{
+				if (script.result.has_value())
+				{
+					cache::store(script.name, script.key, script.result.value());
+					prebuilt_scripts[script.name] = std::move(script.result.value());
+				}
+			}
+		}
+
 		void load_script(const std::string& name)
 		{
 			if (!game::Scr_LoadScript(name.data()))
@@ -220,7 +486,8 @@ namespace gsc
 			}
 		}
 
-		void load_scripts(const std::filesystem::path& root_dir, const std::string& subfolder)
+		void find_scripts(const std::filesystem::path& root_dir, const std::string& subfolder,
+			std::vector<std::string>& names)
 		{
 			std::filesystem::path script_dir = root_dir / subfolder;
 			if (!utils::io::directory_exists(script_dir.generic_string()))
@@ -238,9 +505,7 @@ namespace gsc
 
 				std::filesystem::path path(script);
 				const auto relative = path.lexically_relative(root_dir).generic_string();
-				const auto base_name = relative.substr(0, relative.size() - 4);
-
-				load_script(base_name);
+				names.emplace_back(relative.substr(0, relative.size() - 4));
 			}
 		}
 
@@ -258,22 +523,30 @@ namespace gsc
 		{
 			utils::hook::invoke<void>(0x1404E1400, a1, a2);
 
-			fastfiles::enum_assets(game::ASSET_TYPE_RAWFILE, [](game::XAssetHeader header)
+			std::vector<std::string> names;
+
+			fastfiles::enum_assets(game::ASSET_TYPE_RAWFILE, [&](game::XAssetHeader header)
 			{
 				std::string name = header.rawfile->name;
 
 				if (name.ends_with(".gsc") && name.starts_with("scripts/"))
 				{
-					const auto base_name = name.substr(0, name.size() - 4);
-					load_script(base_name);
+					names.emplace_back(name.substr(0, name.size() - 4));
 				}
 			}, true);
 
 			const auto mapname = game::Dvar_FindVar("mapname");
 			for (const auto& path : filesystem::get_search_paths())
 			{
-				load_scripts(path, "scripts");
-				load_scripts(path, "scripts/"s + mapname->current.string);
+				find_scripts(path, "scripts", names);
+				find_scripts(path, "scripts/"s + mapname->current.string, names);
+			}
+
+			precompile_scripts(names);
+
+			for (const auto& name : names)
+			{
+				load_script(name);
 			}
 		}
 
@@ -315,32 +588,7 @@ namespace gsc
 
 		void scr_begin_load_scripts_stub()
 		{
-			const auto comp_mode = developer_script->current.enabled 
-				? xsk::gsc::build::dev
-				: xsk::gsc::build::prod;
-
-			gsc_ctx->init(comp_mode, [](const std::string& include_name) 
-				-> std::pair<xsk::gsc::buffer, std::vector<std::uint8_t>>
-			{
-				const auto real_name = get_raw_script_file_name(include_name);
-
-				std::string file_buffer;
-				if (!read_raw_script_file(real_name, &file_buffer) || file_buffer.empty())
-				{
-					const auto name = get_script_file_name(include_name);
-					if (game::DB_XAssetExists(game::ASSET_TYPE_SCRIPTFILE, name.data()))
-					{
-						return read_compiled_script_file(name, real_name);
-					}
-
-					throw std::runtime_error(std::format("Could not load gsc file '{}'", real_name));
-				}
-
-				std::vector<std::uint8_t> script_data;
-				script_data.assign(file_buffer.begin(), file_buffer.end());
-
-				return {{}, script_data};
-			});
+			gsc_ctx->init(get_build_mode(), load_include);
 
 			utils::hook::invoke<void>(0x1405BCAE0);
 		}
@@ -350,24 +598,6 @@ namespace gsc
 			gsc_ctx->cleanup();
 			utils::hook::invoke<void>(0x1405BFBF0);
 		}
-
-		void add_function_name(const std::string& name, const std::uint16_t id)
-		{
-			const std::string_view name_ = utils::memory::get_allocator()->duplicate_string(name);
-			auto& func_map = gsc_ctx->func_map();
-			auto func_map_ = reinterpret_cast<std::unordered_map<std::string_view, uint16_t>*>(
-				reinterpret_cast<size_t>(&func_map));
-			func_map_->insert(std::make_pair(name_, id));
-		}
-
-		void add_method_name(const std::string& name, const std::uint16_t id)
-		{
-			const std::string_view name_ = utils::memory::get_allocator()->duplicate_string(name);
-			auto& func_map = gsc_ctx->meth_map();
-			auto func_map_ = reinterpret_cast<std::unordered_map<std::string_view, uint16_t>*>(
-				reinterpret_cast<size_t>(&func_map));
-			func_map_->insert(std::make_pair(name_, id));
-		}
 	}
 
 	game::ScriptFile* find_script(game::XAssetType type, const char* name, int allow_create_default)
@@ -393,7 +623,7 @@ namespace gsc
 	public:
 		void post_load() override
 		{
-			gsc_ctx = std::make_unique<xsk::gsc::h2::context>();
+			gsc_ctx = create_context();
 		}
 
 		void post_unpack() override
@@ -416,10 +646,11 @@ namespace gsc
 			utils::hook::call(0x1404C8F71, g_load_structs_stub);
 			utils::hook::call(0x1404C8F80, scr_load_level_stub);
 
-			add_function_name("isusinghdr", 0x242);
-			add_function_name("tablegetrowcount", 0x2A6);
-			add_function_name("setshaderconstant", 0x2F1);
-			add_method_name("setclutforplayer", 0x849F);
+			command::add("gscCacheStats", []()
+			{
+				const auto stats = cache::get_stats();
+				console::info("GSC bytecode cache: %zu hits, %zu misses\n", stats.hits, stats.misses);
+			});
 
 			scripting::on_shutdown([](bool free_scripts, bool post_shutdown)
 			{
@@ -138,7 +138,7 @@ namespace mod_stats
 		{
 			const auto dump = stats.dump(4);
 			const auto& path_value = path.value();
-			utils::io::write_file(path_value, dump, false);
+			utils::io::write_file_atomic(path_value, dump);
 			globals.modified_stats = false;
 		});
 	}
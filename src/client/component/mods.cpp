@@ -119,6 +119,8 @@ namespace mods
 
 		void full_restart(const std::string& arg)
 		{
+			// Same as updater::relaunch, the deferred config writes would die with the process
+			utils::io::flush_deferred_writes();
 			utils::nt::relaunch_self(" -singleplayer "s.append(arg), true);
 			utils::nt::terminate();
 		}
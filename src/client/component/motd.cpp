@@ -61,20 +61,16 @@ namespace motd
 		std::optional<std::string> read_cached_file(const std::string& name)
 		{
 			const auto path = get_cached_file_name(name);
-			if (!utils::io::file_exists(path))
-			{
-				return {};
-			}
 
 			auto now = std::chrono::system_clock::now();
-			auto data = utils::io::read_file(path);
-			if (data.size() < sizeof(cached_file_header))
+			utils::io::mapped_file file{path};
+			if (!file.is_valid() || file.size() < sizeof(cached_file_header))
 			{
 				return {};
 			}
 
-			auto buffer = data.data();
-			const auto header = reinterpret_cast<cached_file_header*>(buffer);
+			const auto data = file.get_view();
+			const auto header = reinterpret_cast<const cached_file_header*>(data.data());
 			if (header->signature != CACHE_FILE_SIGNATURE)
 			{
 				return {};
@@ -83,12 +79,13 @@ namespace motd
 			const auto date = std::chrono::system_clock::from_time_t(header->date_created);
 			if (now - date >= CACHE_MAX_AGE)
 			{
+				// The mapping has to be released before the file can be deleted
+				file = {};
 				utils::io::remove_file(path);
 				return {};
 			}
 
-			const auto file_data = buffer + sizeof(cached_file_header);
-			return std::string{file_data, data.size() - sizeof(cached_file_header)};
+			return std::string{data.substr(sizeof(cached_file_header))};
 		}
 
 		std::optional<std::string> download_image(const std::string& url)
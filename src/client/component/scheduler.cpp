@@ -2,88 +2,34 @@
 #include "loader/component_loader.hpp"
 
 #include "scheduler.hpp"
+#include "console.hpp"
 #include "game/game.hpp"
 
 #include <utils/thread.hpp>
 #include <utils/hook.hpp>
 #include <utils/concurrency.hpp>
+#include <utils/thread_pool.hpp>
+#include <utils/task_queue.hpp>
 
 namespace scheduler
 {
 	namespace
 	{
-		struct task
-		{
-			std::function<bool()> handler{};
-			std::chrono::milliseconds interval{};
-			std::chrono::high_resolution_clock::time_point last_call{};
-		};
-
-		using task_list = std::vector<task>;
-
-		class task_pipeline
-		{
-		public:
-			void add(task&& task)
-			{
-				new_callbacks_.access([&task](task_list& tasks)
-				{
-					tasks.emplace_back(std::move(task));
-				});
-			}
-
-			void execute()
-			{
-				callbacks_.access([&](task_list& tasks)
-				{
-					this->merge_callbacks();
+		using clock = utils::concurrency::task_queue::clock;
 
-					for (auto i = tasks.begin(); i != tasks.end();)
-					{
-						const auto now = std::chrono::high_resolution_clock::now();
-						const auto diff = now - i->last_call;
-
-						if (diff < i->interval)
-						{
-							++i;
-							continue;
-						}
-
-						i->last_call = now;
-
-						const auto res = i->handler();
-						if (res == cond_end)
-						{
-							i = tasks.erase(i);
-						}
-						else
-						{
-							++i;
-						}
-					}
-				});
-			}
-
-		private:
-			utils::concurrency::container<task_list> new_callbacks_;
-			utils::concurrency::container<task_list, std::recursive_mutex> callbacks_;
-
-			void merge_callbacks()
-			{
-				callbacks_.access([&](task_list& tasks)
-				{
-					new_callbacks_.access([&](task_list& new_tasks)
-					{
-						tasks.insert(tasks.end(), std::move_iterator<task_list::iterator>(new_tasks.begin()), std::move_iterator<task_list::iterator>(new_tasks.end()));
-						new_tasks = {};
-					});
-				});
-			}
-		};
+		// Frame tasks of the async pipeline run at this rate
+		constexpr auto async_frame_interval = 10ms;
 
 		volatile bool kill = false;
 		std::thread thread;
-		task_pipeline pipelines[pipeline::count];
+		utils::concurrency::task_queue pipelines[pipeline::count];
+
+		using pool_ptr = std::unique_ptr<utils::concurrency::thread_pool>;
+		utils::concurrency::container<pool_ptr> pool;
+
+		std::mutex async_mutex;
+		std::condition_variable async_condition;
+		bool async_pending = false;
 		utils::hook::detour r_end_frame_hook;
 		utils::hook::detour g_run_frame_hook;
 		utils::hook::detour main_frame_hook;
@@ -92,7 +38,7 @@ namespace scheduler
 		void execute(const pipeline type)
 		{
 			assert(type >= 0 && type < pipeline::count);
-			pipelines[type].execute();
+			pipelines[type].execute(clock::now());
 		}
 
 		void r_end_frame_stub()
@@ -113,6 +59,67 @@ namespace scheduler
 			execute(pipeline::main);
 		}
 
+		void wake_async()
+		{
+			{
+				std::lock_guard _(async_mutex);
+				async_pending = true;
+			}
+
+			async_condition.notify_one();
+		}
+
+		void run_async()
+		{
+			while (!kill)
+			{
+				execute(pipeline::async);
+
+				// Frame tasks keep the old 10ms tick, otherwise sleep until something is due or gets scheduled
+				const auto deadline = pipelines[pipeline::async].get_next_deadline(clock::now(), async_frame_interval);
+
+				std::unique_lock lock(async_mutex);
+				async_condition.wait_until(lock, deadline, []()
+				{
+					return kill || async_pending;
+				});
+
+				async_pending = false;
+			}
+		}
+
+		// Timing is handled by the async pipeline, due tasks are handed to the pool
+		// and only rescheduled once they finished, so a task never overlaps itself
+		void schedule_on_pool(const std::function<bool()>& callback, const std::chrono::milliseconds delay)
+		{
+			schedule([=]()
+			{
+				post([=]()
+				{
+					if (callback() == cond_continue)
+					{
+						// Rescheduling without a delay would wake the async thread right away and spin,
+						// looping tasks run at most once per async frame like they did on the async pipeline
+						schedule_on_pool(callback, std::max(delay, async_frame_interval));
+					}
+				});
+
+				return cond_end;
+			}, pipeline::async, delay);
+		}
+
+		void run_pool_task(const std::function<void()>& callback)
+		{
+			try
+			{
+				callback();
+			}
+			catch (const std::exception& e)
+			{
+				console::error("Unhandled exception in worker pool task: %s\n", e.what());
+			}
+		}
+
 		void hks_frame_stub()
 		{
 			const auto state = *game::hks::lua_state;
@@ -129,12 +136,18 @@ namespace scheduler
 	{
 		assert(type >= 0 && type < pipeline::count);
 
-		task task;
-		task.handler = callback;
-		task.interval = delay;
-		task.last_call = std::chrono::high_resolution_clock::now();
+		if (type == pipeline::async_pool)
+		{
+			schedule_on_pool(callback, delay);
+			return;
+		}
+
+		pipelines[type].add(callback, delay, clock::now());
 
-		pipelines[type].add(std::move(task));
+		if (type == pipeline::async)
+		{
+			wake_async();
+		}
 	}
 
 	void loop(const std::function<void()>& callback, const pipeline type,
@@ -157,6 +170,39 @@ namespace scheduler
 		}, type, delay);
 	}
 
+	void post(std::function<void()>&& callback)
+	{
+		const auto posted = pool.access<bool>([&](pool_ptr& pool_)
+		{
+			if (!pool_)
+			{
+				return false;
+			}
+
+			pool_->post([callback = std::move(callback)]()
+			{
+				run_pool_task(callback);
+			});
+
+			return true;
+		});
+
+		if (posted)
+		{
+			return;
+		}
+
+		// Nothing runs the async pipeline anymore once it was shut down
+		if (kill)
+		{
+			run_pool_task(callback);
+			return;
+		}
+
+		// The pool is only created in post_start, the async pipeline picks these up once it runs
+		once(callback, pipeline::async);
+	}
+
 	void on_game_initialized(const std::function<void()>& callback, const pipeline type,
 		const std::chrono::milliseconds delay)
 	{
@@ -177,14 +223,12 @@ namespace scheduler
 	public:
 		void post_start() override
 		{
-			thread = utils::thread::create_named_thread("Async Scheduler", []()
+			pool.access([](pool_ptr& pool_)
 			{
-				while (!kill)
-				{
-					execute(pipeline::async);
-					std::this_thread::sleep_for(10ms);
-				}
+				pool_ = std::make_unique<utils::concurrency::thread_pool>("Scheduler Worker");
 			});
+
+			thread = utils::thread::create_named_thread("Async Scheduler", run_async);
 		}
 
 		void post_unpack() override
@@ -198,10 +242,20 @@ namespace scheduler
 		void pre_destroy() override
 		{
 			kill = true;
+			wake_async();
+
 			if (thread.joinable())
 			{
 				thread.join();
 			}
+
+			// Detached first, jobs that post while the workers are joined fall back to the async pipeline
+			auto pool_ = pool.access<pool_ptr>([](pool_ptr& ptr)
+			{
+				return std::move(ptr);
+			});
+
+			pool_ = {};
 		}
 	};
 }
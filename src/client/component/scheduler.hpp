@@ -18,6 +18,9 @@ namespace scheduler
 		// The game's main thread
 		main,
 
+		// Worker pool, disconnected from the game. Tasks run in parallel with each other
+		async_pool,
+
 		count,
 	};
 
@@ -32,4 +35,47 @@ namespace scheduler
 	          std::chrono::milliseconds delay = 0ms);
 	void on_game_initialized(const std::function<void()>& callback, pipeline type = pipeline::async,
 							 std::chrono::milliseconds delay = 0ms);
+
+	// Runs the callback once on the worker pool. Before the pool is started it runs on the async pipeline,
+	// after shutdown it runs inline on the calling thread, so submit() futures always become ready
+	void post(std::function<void()>&& callback);
+
+	template <typename F>
+	auto submit(F&& callback) -> std::future<std::invoke_result_t<F>>
+	{
+		using result_t = std::invoke_result_t<F>;
+
+		const auto task = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(callback));
+		auto future = task->get_future();
+
+		post([task]()
+		{
+			(*task)();
+		});
+
+		return future;
+	}
+
+	// Runs the callback on the worker pool and hands its result to the continuation on the given pipeline
+	template <typename F, typename C>
+	void submit(F&& callback, C&& continuation, const pipeline type = pipeline::main)
+	{
+		using result_t = std::invoke_result_t<F>;
+
+		post([callback = std::forward<F>(callback), continuation = std::forward<C>(continuation), type]() mutable
+		{
+			if constexpr (std::is_void_v<result_t>)
+			{
+				callback();
+				once(continuation, type);
+			}
+			else
+			{
+				once([continuation, result = callback()]()
+				{
+					continuation(result);
+				}, type);
+			}
+		});
+	}
 }
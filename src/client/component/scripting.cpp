@@ -15,14 +15,17 @@
 #include "game/scripting/functions.hpp"
 #include "game/scripting/execution.hpp"
 #include "game/scripting/lua/engine.hpp"
+#include "game/ui_scripting/execution.hpp"
+
+#include "ui_scripting.hpp"
 
 #include <utils/hook.hpp>
 #include <utils/concurrency.hpp>
 
 namespace scripting
 {
-	std::unordered_map<int, std::unordered_map<std::string, int>> fields_table;
-	std::unordered_map<std::string, std::unordered_map<std::string, const char*>> script_function_table;
+	std::unordered_map<int, utils::flat_string_map<int>> fields_table;
+	utils::flat_string_map<utils::flat_string_map<const char*>> script_function_table;
 	std::unordered_map<std::string, std::vector<std::pair<std::string, const char*>>> script_function_table_sort;
 	utils::concurrency::container<shared_table_t> shared_table;
 
@@ -60,8 +63,70 @@ namespace scripting
 
 		std::unordered_map<unsigned int, std::string> canonical_string_table;
 
-		using notify_list = std::vector<event>;
-		utils::concurrency::container<notify_list> scheduled_notifies;
+		struct function_range
+		{
+			std::string name;
+			std::string file;
+			const char* end;
+		};
+
+		// Every function recorded by add_function_sort, keyed by its start position
+		std::map<const char*, function_range> script_function_index;
+
+		struct captured_notify
+		{
+			entity entity;
+			variable_value name;
+			size_t argument_offset;
+			size_t argument_count;
+		};
+
+		// Notifies captured during a frame. Names stay string ids and arguments are stored back to back,
+		// the buffers keep their capacity so capturing stops allocating once they have grown
+		struct notify_buffer
+		{
+			std::vector<captured_notify> notifies;
+			std::vector<script_value> arguments;
+
+			void add(const unsigned int entity_id, const game::scr_string_t name, const game::VariableValue* top)
+			{
+				const auto argument_offset = this->arguments.size();
+				for (auto* value = top; value->type != game::SCRIPT_END; --value)
+				{
+					this->arguments.emplace_back(*value);
+				}
+
+				game::VariableValue name_value{};
+				name_value.type = game::SCRIPT_STRING;
+				name_value.u.stringValue = static_cast<unsigned int>(name);
+
+				this->notifies.emplace_back(captured_notify{entity_id, name_value, argument_offset,
+					this->arguments.size() - argument_offset});
+			}
+
+			void clear()
+			{
+				this->notifies.clear();
+				this->arguments.clear();
+			}
+		};
+
+		utils::concurrency::container<notify_buffer> scheduled_notifies;
+
+		// Only touched by the thread running the scripts, swapped with the scheduled notifies every frame
+		notify_buffer processed_notifies;
+		event current_notify;
+
+		void handle_endon_conditions(const unsigned int entity_id, const char* name)
+		{
+			thread_local event endon_event{};
+			endon_event.name.assign(name);
+			endon_event.entity = entity_id;
+
+			lua::engine::handle_endon_conditions(endon_event);
+
+			endon_event.entity = {};
+		}
 
 		void vm_notify_stub(const unsigned int notify_list_owner_id, const game::scr_string_t string_value,
 		                    game::VariableValue* top)
@@ -69,21 +134,16 @@ namespace scripting
 			const auto* string = game::SL_ConvertToString(string_value);
 			if (string)
 			{
-				event e;
-				e.name = string;
-				e.entity = notify_list_owner_id;
+				handle_endon_conditions(notify_list_owner_id, string);
 
-				for (auto* value = top; value->type != game::SCRIPT_END; --value)
+				// Nothing would consume the notify, don't copy its arguments
+				if (lua::engine::has_event_listeners(string))
 				{
-					e.arguments.emplace_back(*value);
+					scheduled_notifies.access([&](notify_buffer& buffer)
+					{
+						buffer.add(notify_list_owner_id, string_value, top);
+					});
 				}
-
-				lua::engine::handle_endon_conditions(e);
-
-				scheduled_notifies.access([&](notify_list& list)
-				{
-					list.push_back(e);
-				});
 			}
 
 			vm_notify_hook.invoke<void>(notify_list_owner_id, string_value, top);
@@ -92,9 +152,9 @@ namespace scripting
 		void clear_scheduled_notifies()
 		{
 			get_dvar_int_overrides.clear();
-			scheduled_notifies.access([](notify_list& list)
+			scheduled_notifies.access([](notify_buffer& buffer)
 			{
-				list.clear();
+				buffer.clear();
 			});
 		}
 
@@ -111,6 +171,7 @@ namespace scripting
 			if (free_scripts)
 			{
 				script_function_table_sort.clear();
+				script_function_index.clear();
 				script_function_table.clear();
 				canonical_string_table.clear();
 			}
@@ -133,10 +194,10 @@ namespace scripting
 		void scr_add_class_field_stub(unsigned int classnum, game::scr_string_t name, unsigned int canonicalString, unsigned int offset)
 		{
 			const auto name_ = game::SL_ConvertToString(name);
-
-			if (fields_table[classnum].find(name_) == fields_table[classnum].end())
+			const auto [field, inserted] = fields_table[classnum].try_emplace(name_);
+			if (inserted)
 			{
-				fields_table[classnum][name_] = offset;
+				field->second = offset;
 			}
 
 			scr_add_class_field_hook.invoke<void>(classnum, name, canonicalString, offset);
@@ -193,6 +254,18 @@ namespace scripting
 			const auto name = get_token_single(id);
 			auto& itr = script_function_table_sort[filename];
 			itr.insert(itr.end() - 1, {name, pos});
+
+			// The previous function of the file now ends where this one starts
+			if (itr.size() >= 3)
+			{
+				const auto previous = script_function_index.find(itr[itr.size() - 3].second);
+				if (previous != script_function_index.end())
+				{
+					previous->second.end = pos;
+				}
+			}
+
+			script_function_index.insert_or_assign(pos, function_range{name, filename, itr.back().second});
 		}
 
 		void add_function(const std::string& file, unsigned int id, const char* pos)
@@ -256,18 +329,29 @@ namespace scripting
 
 		void scr_run_current_threads_stub()
 		{
-			notify_list list_copy{};
-			scheduled_notifies.access([&](notify_list& list)
+			scheduled_notifies.access([&](notify_buffer& buffer)
 			{
-				list_copy = list;
-				list.clear();
+				std::swap(buffer, processed_notifies);
 			});
 
-			for (const auto& e : list_copy)
+			const auto& arguments = processed_notifies.arguments;
+			for (const auto& notify : processed_notifies.notifies)
 			{
-				lua::engine::notify(e);
+				const auto argument = arguments.begin() + notify.argument_offset;
+
+				// Only notifies that had a listener when they were captured get here
+				current_notify.name.assign(game::SL_ConvertToString(
+					static_cast<game::scr_string_t>(notify.name.get().u.stringValue)));
+				current_notify.entity = notify.entity;
+				current_notify.arguments.assign(argument, argument + notify.argument_count);
+
+				lua::engine::notify(current_notify);
 			}
 
+			current_notify.entity = {};
+			current_notify.arguments.clear();
+			processed_notifies.clear();
+
 			scr_run_current_threads_hook.invoke<void>();
 		}
 
@@ -318,6 +402,23 @@ namespace scripting
 		return scripting::find_token_single(id);
 	}
 
+	std::optional<std::pair<std::string, std::string>> find_function_by_pos(const char* pos)
+	{
+		auto itr = script_function_index.upper_bound(pos);
+		if (itr == script_function_index.begin())
+		{
+			return {};
+		}
+
+		--itr;
+		if (pos >= itr->second.end)
+		{
+			return {};
+		}
+
+		return {std::make_pair(itr->second.name, itr->second.file)};
+	}
+
 	void on_shutdown(const std::function<void(bool, bool)>& callback)
 	{
 		shutdown_callbacks.push_back(callback);
@@ -376,6 +477,27 @@ namespace scripting
 				console::info("%p\n", func);
 			});
 
+			dvars::lua_gcBudget = dvars::register_int("lua_gcBudget", 500, 0, 100000, game::DVAR_FLAG_SAVED,
+				"Time in microseconds each Lua state may spend collecting garbage per frame");
+
+			command::add("luaGcStats", []()
+			{
+				const auto print_stats = [](const std::string& name, const lua::gc_stats& stats)
+				{
+					console::info("%s: heap %zu KB, last frame %lld us, max frame %lld us, total %lld ms, %llu steps, %llu cycles\n",
+						name.data(), stats.heap_size >> 10, stats.frame_time.count(), stats.max_frame_time.count(),
+						std::chrono::duration_cast<std::chrono::milliseconds>(stats.total_time).count(),
+						stats.steps, stats.cycles);
+				};
+
+				for (const auto& [name, stats] : lua::engine::get_gc_stats())
+				{
+					print_stats(name, stats);
+				}
+
+				print_stats("lui", ui_scripting::get_gc_stats());
+			});
+
 			scheduler::loop([]()
 			{
 				lua::engine::run_frame();
@@ -1,12 +1,13 @@
 #pragma once
 #include <utils/concurrency.hpp>
+#include <utils/flat_map.hpp>
 
 namespace scripting
 {
 	using shared_table_t = std::unordered_map<std::string, std::string>;
 
-	extern std::unordered_map<int, std::unordered_map<std::string, int>> fields_table;
-	extern std::unordered_map<std::string, std::unordered_map<std::string, const char*>> script_function_table;
+	extern std::unordered_map<int, utils::flat_string_map<int>> fields_table;
+	extern utils::flat_string_map<utils::flat_string_map<const char*>> script_function_table;
 	extern std::unordered_map<std::string, std::vector<std::pair<std::string, const char*>>> script_function_table_sort;
 	extern utils::concurrency::container<shared_table_t> shared_table;
 
@@ -14,6 +15,8 @@ namespace scripting
 
 	extern std::string current_file;
 
+	std::optional<std::pair<std::string, std::string>> find_function_by_pos(const char* pos);
+
 	void on_shutdown(const std::function<void(bool, bool)>& callback);
 	std::optional<std::string> get_canonical_string(const unsigned int id);
 	std::string get_token_single(unsigned int id);
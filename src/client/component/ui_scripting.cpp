@@ -53,6 +53,9 @@ namespace ui_scripting
 
 		globals_t globals{};
 
+		bool hks_gc_enabled{};
+		scripting::lua::gc_stats hks_gc_stats{};
+
 		bool is_loaded_script(const std::string& name)
 		{
 			return globals.loaded_scripts.contains(name);
@@ -792,14 +795,54 @@ namespace ui_scripting
 			}
 		}
 
+		void run_gc_frame()
+		{
+			if (!hks_gc_enabled)
+			{
+				return;
+			}
+
+			try
+			{
+				const auto collect_garbage = get_globals()["collectgarbage"];
+
+				// HKS has no exported lua_gc, the step goes through the base library instead
+				scripting::lua::run_gc_steps(hks_gc_stats, [&]()
+				{
+					const auto result = collect_garbage("step", 0);
+					if (result.empty() || !result[0].is<bool>())
+					{
+						throw std::runtime_error("collectgarbage(\"step\") is not available");
+					}
+
+					return result[0].as<bool>();
+				});
+
+				const auto state = *game::hks::lua_state;
+				hks_gc_stats.heap_size = state->m_global->m_memory.m_used;
+			}
+			catch (const std::exception& e)
+			{
+				hks_gc_enabled = false;
+				console::error("Disabled LUI garbage collection budget: %s\n", e.what());
+			}
+		}
+
 		void hks_start_stub(char a1)
 		{
-			const auto _0 = gsl::finally(&try_start);
+			const auto _0 = gsl::finally([]()
+			{
+				try_start();
+				hks_gc_stats = {};
+				hks_gc_enabled = true;
+			});
+
 			return hks_start_hook.invoke<void>(a1);
 		}
 
 		void hks_shutdown_stub()
 		{
+			hks_gc_enabled = false;
 			camera::clear_lua();
 			converted_functions.clear();
 			globals = {};
@@ -912,12 +955,19 @@ namespace ui_scripting
 		return closure;
 	}
 
+	scripting::lua::gc_stats get_gc_stats()
+	{
+		return hks_gc_stats;
+	}
+
 	class component final : public component_interface
 	{
 	public:
 
 		void post_unpack() override
 		{
+			scheduler::loop(run_gc_frame, scheduler::pipeline::lui);
+
 			utils::hook::call(0x14030BF2B, db_find_xasset_header_stub);
 			utils::hook::call(0x14030C079, db_find_xasset_header_stub);
 			utils::hook::call(0x14030C104, hks_load_stub);
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "game/scripting/lua/gc_controller.hpp"
+
 namespace ui_scripting
 {
+	scripting::lua::gc_stats get_gc_stats();
+
 	template <class... Args, std::size_t... I>
 	auto wrap_function(const std::function<void(Args...)>& f, std::index_sequence<I...>)
 	{
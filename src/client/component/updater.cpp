@@ -133,26 +133,20 @@ namespace updater
 
 		bool check_file(const std::string& name, const std::string& sha)
 		{
-			std::string data;
-
-			if (get_binary_name() == name)
+			std::string path = name;
+			if (get_binary_name() != name)
 			{
-				if (!utils::io::read_file(name, &data))
-				{
-					return false;
-				}
+				const auto appdata_folder = utils::properties::get_appdata_path();
+				path = (appdata_folder / name).generic_string();
 			}
-			else
+
+			const utils::io::mapped_file data{path};
+			if (!data.is_valid())
 			{
-				const auto appdata_folder = utils::properties::get_appdata_path();
-				const auto path = (appdata_folder / name).generic_string();
-				if (!utils::io::read_file(path, &data))
-				{
-					return false;
-				}
+				return false;
 			}
 
-			if (utils::cryptography::sha1::compute(data, true) != sha)
+			if (utils::cryptography::sha1::compute(data.data(), data.size(), true) != sha)
 			{
 				return false;
 			}
@@ -287,6 +281,8 @@ namespace updater
 
 	void relaunch()
 	{
+		// Terminating skips pre_destroy, pending config writes have to land before the new process reads them
+		utils::io::flush_deferred_writes();
 		utils::nt::relaunch_self("-singleplayer");
 		utils::nt::terminate();
 	}
@@ -28,6 +28,8 @@ namespace dvars
 
 	game::dvar_t* g_enableElevators = nullptr;
 
+	game::dvar_t* lua_gcBudget = nullptr;
+
 	std::string dvar_get_vector_domain(const int components, const game::dvar_limits& domain)
 	{
 		if (domain.vector.min == -FLT_MAX)
@@ -37,6 +37,8 @@ namespace dvars
 
 	extern game::dvar_t* g_enableElevators;
 
+	extern game::dvar_t* lua_gcBudget;
+
 	WEAK game::symbol<game::dvar_t*> com_max_fps{0x14AE2C890};
 	WEAK game::symbol<game::dvar_t*> cg_draw_2d{0x141E39EC0};
 
@@ -16,14 +16,16 @@ namespace scripting
 			return value_ptr;
 		}
 
-		int get_field_id(const int classnum, const std::string& field)
+		int get_field_id(const int classnum, const std::string_view field)
 		{
-			if (scripting::fields_table[classnum].find(field) != scripting::fields_table[classnum].end())
+			const auto fields = scripting::fields_table.find(classnum);
+			if (fields == scripting::fields_table.end())
 			{
-				return scripting::fields_table[classnum][field];
+				return -1;
 			}
 
-			return -1;
+			const auto* id = fields->second.find(field);
+			return id ? *id : -1;
 		}
 
 		script_value get_return_value()
@@ -54,6 +56,32 @@ namespace scripting
 
 			return false;
 		}
+
+		bool is_method_call(const game::scr_entref_t& entref)
+		{
+			return *reinterpret_cast<const int*>(&entref) != -1;
+		}
+
+		// Expects the stack to be isolated already
+		script_value invoke_function(const script_function function, const game::scr_entref_t& entref,
+			const std::string& name, const std::vector<script_value>& arguments)
+		{
+			for (auto i = arguments.rbegin(); i != arguments.rend(); ++i)
+			{
+				push_value(*i);
+			}
+
+			game::scr_VmPub->outparamcount = game::scr_VmPub->inparamcount;
+			game::scr_VmPub->inparamcount = 0;
+
+			if (!safe_execution::call(function, entref))
+			{
+				throw std::runtime_error(
+					"Error executing "s + (is_method_call(entref) ? "method" : "function") + " '" + name + "'");
+			}
+
+			return get_return_value();
+		}
 	}
 
 	void push_value(const script_value& value)
@@ -87,30 +115,72 @@ namespace scripting
 			return {};
 		}
 
-		const auto is_method_call = *reinterpret_cast<const int*>(&entref) != -1;
-		const auto function = find_function(name, !is_method_call);
+		const auto is_method = is_method_call(entref);
+		const auto function = find_function(name, !is_method);
 		if (function == nullptr)
 		{
-			throw std::runtime_error("Unknown "s + (is_method_call ? "method" : "function") + " '" + name + "'");
+			throw std::runtime_error("Unknown "s + (is_method ? "method" : "function") + " '" + name + "'");
 		}
 
 		stack_isolation _;
+		return invoke_function(function, entref, name, arguments);
+	}
 
-		for (auto i = arguments.rbegin(); i != arguments.rend(); ++i)
+	prepared_call::prepared_call(const std::string& name)
+		: name_(name)
+		, function_(find_function(name, true))
+	{
+		if (this->function_ == nullptr)
 		{
-			push_value(*i);
+			throw std::runtime_error("Unknown function '" + name + "'");
+		}
+	}
+
+	script_value prepared_call::call(const entity& entity, const std::vector<script_value>& arguments) const
+	{
+		const auto entref = entity.get_entity_reference();
+		if (!is_entity_variable(entref, entity.get_entity_id()))
+		{
+			return {};
 		}
 
-		game::scr_VmPub->outparamcount = game::scr_VmPub->inparamcount;
-		game::scr_VmPub->inparamcount = 0;
+		stack_isolation _;
+		return invoke_function(this->function_, entref, this->name_, arguments);
+	}
+
+	script_value prepared_call::call(const std::vector<script_value>& arguments) const
+	{
+		return this->call(entity(), arguments);
+	}
+
+	std::vector<script_value> prepared_call::call_batch(const std::vector<entity>& entities,
+		const std::vector<script_value>& arguments) const
+	{
+		std::vector<script_value> results;
+		results.reserve(entities.size());
 
-		if (!safe_execution::call(function, entref))
+		stack_isolation _;
+
+		for (const auto& entity : entities)
 		{
-			throw std::runtime_error(
-				"Error executing "s + (is_method_call ? "method" : "function") + " '" + name + "'");
+			const auto entref = entity.get_entity_reference();
+			if (!is_entity_variable(entref, entity.get_entity_id()))
+			{
+				results.emplace_back();
+				continue;
+			}
+
+			// Drops the previous call's return value
+			game::Scr_ClearOutParams();
+			results.emplace_back(invoke_function(this->function_, entref, this->name_, arguments));
 		}
 
-		return get_return_value();
+		return results;
+	}
+
+	const std::string& prepared_call::get_name() const
+	{
+		return this->name_;
 	}
 
 	script_value call_function(const std::string& name, const std::vector<script_value>& arguments)
@@ -145,18 +215,19 @@ namespace scripting
 
 	const char* get_function_pos(const std::string& filename, const std::string& function)
 	{
-		if (scripting::script_function_table.find(filename) == scripting::script_function_table.end())
+		const auto* functions = scripting::script_function_table.find(filename);
+		if (!functions)
 		{
 			throw std::runtime_error("File '" + filename + "' not found");
 		};
 
-		const auto& functions = scripting::script_function_table[filename];
-		if (functions.find(function) == functions.end())
+		const auto* pos = functions->find(function);
+		if (!pos)
 		{
 			throw std::runtime_error("Function '" + function + "' in file '" + filename + "' not found");
 		}
 
-		return functions.at(function);
+		return *pos;
 	}
 
 	script_value call_script_function(const entity& entity, const std::string& filename,
@@ -166,13 +237,33 @@ namespace scripting
 		return exec_ent_thread(entity, pos, arguments);
 	}
 
+	entity_field resolve_entity_field(const unsigned int classnum, const std::string_view field)
+	{
+		entity_field result{};
+		result.name = field;
+		result.classnum = classnum;
+		result.id = get_field_id(classnum, field);
+		result.token_id = result.id == -1 ? find_token_id(result.name) : 0;
+		return result;
+	}
+
 	void set_entity_field(const entity& entity, const std::string& field, const script_value& value)
+	{
+		set_entity_field(entity, resolve_entity_field(entity.get_entity_reference().classnum, field), value);
+	}
+
+	void set_entity_field(const entity& entity, const entity_field& field, const script_value& value)
 	{
 		const auto entref = entity.get_entity_reference();
-		const int id = get_field_id(entref.classnum, field);
+		if (entref.classnum != field.classnum)
+		{
+			set_entity_field(entity, field.name, value);
+			return;
+		}
+
 		const auto ent_id = entity.get_entity_id();
 
-		if (id != -1 && is_entity_variable(entref, ent_id))
+		if (field.id != -1 && is_entity_variable(entref, ent_id))
 		{
 			stack_isolation _;
 			push_value(value);
@@ -180,31 +271,41 @@ namespace scripting
 			game::scr_VmPub->outparamcount = game::scr_VmPub->inparamcount;
 			game::scr_VmPub->inparamcount = 0;
 
-			if (!safe_execution::set_entity_field(entref, id))
+			if (!safe_execution::set_entity_field(entref, field.id))
 			{
-				throw std::runtime_error("Failed to set value for field '" + field + "'");
+				throw std::runtime_error("Failed to set value for field '" + field.name + "'");
 			}
 		}
 		else
 		{
-			set_object_variable(ent_id, field, value);
+			const auto token_id = field.id == -1 ? field.token_id : find_token_id(field.name);
+			set_object_variable(ent_id, token_id, value);
 		}
 	}
 
 	script_value get_entity_field(const entity& entity, const std::string& field)
+	{
+		return get_entity_field(entity, resolve_entity_field(entity.get_entity_reference().classnum, field));
+	}
+
+	script_value get_entity_field(const entity& entity, const entity_field& field)
 	{
 		const auto entref = entity.get_entity_reference();
-		const auto id = get_field_id(entref.classnum, field);
+		if (entref.classnum != field.classnum)
+		{
+			return get_entity_field(entity, field.name);
+		}
+
 		const auto ent_id = entity.get_entity_id();
 
-		if (id != -1 && is_entity_variable(entref, ent_id))
+		if (field.id != -1 && is_entity_variable(entref, ent_id))
 		{
 			stack_isolation _;
 
 			game::VariableValue value{};
-			if (!safe_execution::get_entity_field(entref, id, &value))
+			if (!safe_execution::get_entity_field(entref, field.id, &value))
 			{
-				throw std::runtime_error("Failed to get value for field '" + field + "'");
+				throw std::runtime_error("Failed to get value for field '" + field.name + "'");
 			}
 
 			const auto __ = gsl::finally([value]()
@@ -215,7 +316,8 @@ namespace scripting
 			return value;
 		}
 
-		return get_object_variable(ent_id, field);
+		const auto token_id = field.id == -1 ? field.token_id : find_token_id(field.name);
+		return get_object_variable(ent_id, token_id);
 	}
 
 	unsigned int make_array()
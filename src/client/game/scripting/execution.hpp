@@ -26,13 +26,48 @@ namespace scripting
 		return call<script_value>(name, arguments).as<T>();
 	}
 
+	// Builtin resolved once, for calling the same function or method repeatedly
+	class prepared_call final
+	{
+	public:
+		explicit prepared_call(const std::string& name);
+
+		script_value call(const entity& entity, const std::vector<script_value>& arguments) const;
+
+		// Calls the builtin without self, like call_function without an entity
+		script_value call(const std::vector<script_value>& arguments) const;
+
+		// Calls the builtin on every entity within a single isolated stack
+		std::vector<script_value> call_batch(const std::vector<entity>& entities,
+			const std::vector<script_value>& arguments) const;
+
+		const std::string& get_name() const;
+
+	private:
+		std::string name_;
+		script_function function_;
+	};
+
 	script_value exec_ent_thread(const entity& entity, const char* pos, const std::vector<script_value>& arguments);
 	const char* get_function_pos(const std::string& filename, const std::string& function);
 	script_value call_script_function(const entity& entity, const std::string& filename,
 		const std::string& function, const std::vector<script_value>& arguments);
 
+	// Entity field resolved for one entity class, accessing it through this skips the name lookups
+	struct entity_field
+	{
+		std::string name;
+		unsigned int classnum;
+		int id;
+		unsigned int token_id;
+	};
+
+	entity_field resolve_entity_field(unsigned int classnum, std::string_view field);
+
 	void set_entity_field(const entity& entity, const std::string& field, const script_value& value);
+	void set_entity_field(const entity& entity, const entity_field& field, const script_value& value);
 	script_value get_entity_field(const entity& entity, const std::string& field);
+	script_value get_entity_field(const entity& entity, const entity_field& field);
 
 	void notify(const entity& entity, const std::string& event, const std::vector<script_value>& arguments);
 
@@ -0,0 +1,128 @@
+#include <std_include.hpp>
+#include "chunk_cache.hpp"
+
+#include <utils/concurrency.hpp>
+#include <utils/cryptography.hpp>
+#include <utils/io.hpp>
+
+namespace scripting::lua::chunk_cache
+{
+	namespace
+	{
+		struct cached_chunk
+		{
+			std::filesystem::file_time_type write_time;
+			std::string hash;
+			std::string bytecode;
+		};
+
+		utils::concurrency::container<std::unordered_map<std::string, cached_chunk>> chunks;
+
+		int dump_writer(lua_State*, const void* data, const size_t size, void* buffer)
+		{
+			static_cast<std::string*>(buffer)->append(static_cast<const char*>(data), size);
+			return 0;
+		}
+
+		std::string_view get_source_code(const std::string& source)
+		{
+			// Mirror luaL_loadfile: skip a UTF-8 BOM and a leading '#' line, keeping its newline
+			std::string_view code{source};
+			if (code.starts_with("\xEF\xBB\xBF"))
+			{
+				code.remove_prefix(3);
+			}
+
+			if (code.starts_with('#'))
+			{
+				const auto end = code.find('\n');
+				code.remove_prefix(end == std::string_view::npos ? code.size() : end);
+			}
+
+			return code;
+		}
+
+		std::optional<std::string> find_bytecode(const std::string& path,
+			const std::filesystem::file_time_type write_time, const std::string* hash)
+		{
+			return chunks.access<std::optional<std::string>>([&](std::unordered_map<std::string, cached_chunk>& map)
+				-> std::optional<std::string>
+			{
+				const auto entry = map.find(path);
+				if (entry == map.end())
+				{
+					return {};
+				}
+
+				if (entry->second.write_time != write_time)
+				{
+					// Files that were only touched keep their bytecode
+					if (!hash || entry->second.hash != *hash)
+					{
+						return {};
+					}
+
+					entry->second.write_time = write_time;
+				}
+
+				return {entry->second.bytecode};
+			});
+		}
+
+		sol::load_result make_result(lua_State* state, const int status)
+		{
+			return {state, lua_absindex(state, -1), 1, 1, static_cast<sol::load_status>(status)};
+		}
+	}
+
+	sol::load_result load_file(lua_State* state, const std::string& path)
+	{
+		const auto chunk_name = "@" + path;
+
+		std::error_code ec{};
+		const auto write_time = std::filesystem::last_write_time(path, ec);
+
+		if (!ec)
+		{
+			const auto bytecode = find_bytecode(path, write_time, nullptr);
+			if (bytecode.has_value())
+			{
+				const auto status = luaL_loadbufferx(state, bytecode->data(), bytecode->size(), chunk_name.data(), "b");
+				return make_result(state, status);
+			}
+		}
+
+		std::string source{};
+		if (ec || !utils::io::read_file(path, &source))
+		{
+			lua_pushfstring(state, "cannot open %s", path.data());
+			return make_result(state, LUA_ERRFILE);
+		}
+
+		const auto hash = utils::cryptography::sha1::compute(source);
+		const auto bytecode = find_bytecode(path, write_time, &hash);
+		if (bytecode.has_value())
+		{
+			const auto status = luaL_loadbufferx(state, bytecode->data(), bytecode->size(), chunk_name.data(), "b");
+			return make_result(state, status);
+		}
+
+		const auto code = get_source_code(source);
+		const auto status = luaL_loadbufferx(state, code.data(), code.size(), chunk_name.data(), nullptr);
+		if (status != LUA_OK)
+		{
+			return make_result(state, status);
+		}
+
+		// Debug info is kept so errors still report file lines
+		cached_chunk chunk{write_time, hash, {}};
+		lua_dump(state, dump_writer, &chunk.bytecode, 0);
+
+		chunks.access([&](std::unordered_map<std::string, cached_chunk>& map)
+		{
+			map.insert_or_assign(path, std::move(chunk));
+		});
+
+		return make_result(state, status);
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "context.hpp"
+
+namespace scripting::lua::chunk_cache
+{
+	// Loads a script file as a function on top of the stack, sharing the compiled bytecode
+	// between all contexts. Entries are revalidated against the file's write time and content hash
+	sol::load_result load_file(lua_State* state, const std::string& path);
+}
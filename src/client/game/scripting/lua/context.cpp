@@ -2,6 +2,8 @@
 #include "context.hpp"
 #include "error.hpp"
 #include "value_conversion.hpp"
+#include "json.hpp"
+#include "chunk_cache.hpp"
 
 #include "game/scripting/execution.hpp"
 
@@ -20,13 +22,63 @@
 
 #include <utils/string.hpp>
 #include <utils/io.hpp>
-#include <utils/nt.hpp>
 
 namespace scripting::lua
 {
 	namespace
 	{
-		const auto json_script = utils::nt::load_resource(LUA_JSON);
+		// Keeps the converted arguments around so repeated calls don't reallocate them
+		struct lua_prepared_call
+		{
+			prepared_call call;
+			std::vector<script_value> arguments;
+			std::vector<entity> entities;
+
+			void set_arguments(const sol::this_state s, const sol::variadic_args& va)
+			{
+				this->arguments.clear();
+
+				for (auto arg : va)
+				{
+					this->arguments.push_back(convert({s, arg}));
+				}
+			}
+		};
+
+		struct entity_field_ref
+		{
+			entity entity;
+			entity_field field;
+		};
+
+		// Resolved entity fields keyed by the address of the interned Lua string. The name is
+		// compared as well, a collected string's address can be reused for a different one.
+		class entity_field_cache final
+		{
+		public:
+			const entity_field& get(const unsigned int classnum, const std::string_view name)
+			{
+				const auto key = reinterpret_cast<std::uintptr_t>(name.data()) ^ (static_cast<std::uint64_t>(classnum) << 48);
+
+				const auto itr = this->fields_.find(key);
+				if (itr != this->fields_.end() && itr->second.classnum == classnum && itr->second.name == name)
+				{
+					return itr->second;
+				}
+
+				// Dynamically built names would otherwise grow the cache forever
+				if (this->fields_.size() >= max_entries)
+				{
+					this->fields_.clear();
+				}
+
+				return this->fields_.insert_or_assign(key, resolve_entity_field(classnum, name)).first->second;
+			}
+
+		private:
+			static constexpr size_t max_entries = 4096;
+			std::unordered_map<std::uint64_t, entity_field> fields_;
+		};
 
 		vector normalize_vector(const vector& vec)
 		{
@@ -55,11 +107,37 @@ namespace scripting::lua
 			state["package"]["loadlib"] = sol::lua_value{state, sol::lua_nil};
 		}
 
-		void setup_json(sol::state& state)
+		void setup_module_loader(sol::state& state)
 		{
-			const auto json = state.safe_script(json_script, &sol::script_pass_on_error);
-			handle_error(json);
-			state["json"] = json;
+			// Replaces the Lua file searcher so required modules come from the shared chunk cache
+			state["package"]["searchers"][2] = [](const sol::this_state s, const std::string& name)
+			{
+				sol::state_view state{s};
+				sol::variadic_results results{};
+
+				const sol::function searchpath = state["package"]["searchpath"];
+				const std::tuple<sol::object, sol::object> found = searchpath(name, state["package"]["path"]);
+
+				const auto& [path, error] = found;
+				if (!path.is<std::string>())
+				{
+					results.push_back(error);
+					return results;
+				}
+
+				const auto file = path.as<std::string>();
+				auto chunk = chunk_cache::load_file(s, file);
+				if (!chunk.valid())
+				{
+					const sol::error err = chunk;
+					throw std::runtime_error(std::format("error loading module '{}' from file '{}':\n\t{}",
+						name, file, err.what()));
+				}
+
+				results.push_back(chunk.get<sol::object>());
+				results.push_back(path);
+				return results;
+			};
 		}
 
 		void setup_io(sol::state& state)
@@ -434,15 +512,42 @@ namespace scripting::lua
 				return convert(s, entity.call(function, arguments));
 			};
 
-			entity_type[sol::meta_function::new_index] = [](const entity& entity, const std::string& field,
+			const auto field_cache = std::make_shared<entity_field_cache>();
+
+			entity_type[sol::meta_function::new_index] = [field_cache](const entity& entity, const std::string_view field,
 															const sol::lua_value& value)
 			{
-				entity.set(field, convert(value));
+				const auto& resolved = field_cache->get(entity.get_entity_reference().classnum, field);
+				set_entity_field(entity, resolved, convert(value));
 			};
 
-			entity_type[sol::meta_function::index] = [](const entity& entity, const sol::this_state s, const std::string& field)
+			entity_type[sol::meta_function::index] = [field_cache](const entity& entity, const sol::this_state s,
+				const std::string_view field)
 			{
-				return convert(s, entity.get(field));
+				const auto& resolved = field_cache->get(entity.get_entity_reference().classnum, field);
+				return convert(s, get_entity_field(entity, resolved));
+			};
+
+			auto entity_field_ref_type = state.new_usertype<entity_field_ref>("entity_field_ref");
+
+			entity_field_ref_type["get"] = [](const entity_field_ref& ref, const sol::this_state s)
+			{
+				return convert(s, get_entity_field(ref.entity, ref.field));
+			};
+
+			entity_field_ref_type["set"] = [](const entity_field_ref& ref, const sol::lua_value& value)
+			{
+				set_entity_field(ref.entity, ref.field, convert(value));
+			};
+
+			entity_field_ref_type["name"] = sol::property([](const entity_field_ref& ref)
+			{
+				return ref.field.name;
+			});
+
+			entity_type["fieldref"] = [](const entity& entity, const std::string& field)
+			{
+				return entity_field_ref{entity, resolve_entity_field(entity.get_entity_reference().classnum, field)};
 			};
 
 			entity_type["struct"] = sol::property([](const entity& entity, const sol::this_state s)
@@ -585,6 +690,55 @@ namespace scripting::lua
 				return convert(s, call(function, arguments));
 			};
 
+			auto prepared_call_type = state.new_usertype<lua_prepared_call>("prepared_call");
+
+			prepared_call_type["call"] = [](lua_prepared_call& prepared, const sol::this_state s, const entity& entity,
+				sol::variadic_args va)
+			{
+				prepared.set_arguments(s, va);
+				return convert(s, prepared.call.call(entity, prepared.arguments));
+			};
+
+			prepared_call_type["callglobal"] = [](lua_prepared_call& prepared, const sol::this_state s,
+				sol::variadic_args va)
+			{
+				prepared.set_arguments(s, va);
+				return convert(s, prepared.call.call(prepared.arguments));
+			};
+
+			prepared_call_type["callbatch"] = [](lua_prepared_call& prepared, const sol::this_state s,
+				const sol::table& entities, sol::variadic_args va)
+			{
+				prepared.set_arguments(s, va);
+
+				prepared.entities.clear();
+				for (size_t i = 1; i <= entities.size(); ++i)
+				{
+					prepared.entities.emplace_back(entities.get<entity>(i));
+				}
+
+				auto results = sol::table::create(s.lua_state());
+				const auto values = prepared.call.call_batch(prepared.entities, prepared.arguments);
+
+				for (size_t i = 0; i < values.size(); ++i)
+				{
+					results[i + 1] = convert(s, values[i]);
+				}
+
+				prepared.entities.clear();
+				return results;
+			};
+
+			prepared_call_type["name"] = sol::property([](const lua_prepared_call& prepared)
+			{
+				return prepared.call.get_name();
+			});
+
+			game_type["preparecall"] = [](const game&, const std::string& function)
+			{
+				return lua_prepared_call{prepared_call{function}, {}, {}};
+			};
+
 			game_type["ontimeout"] = [&scheduler](const game&, const sol::protected_function& callback,
 			                                      const long long milliseconds)
 			{
@@ -655,14 +809,15 @@ namespace scripting::lua
 
 			game_type["getfunctions"] = [](const game&, const sol::this_state s, const std::string& filename)
 			{
-				if (scripting::script_function_table.find(filename) == scripting::script_function_table.end())
+				const auto* file_functions = scripting::script_function_table.find(filename);
+				if (!file_functions)
 				{
 					throw std::runtime_error("File '" + filename + "' not found");
 				}
 
 				auto functions = sol::table::create(s.lua_state());
 
-				for (const auto& function : scripting::script_function_table[filename])
+				for (const auto& function : *file_functions)
 				{
 					functions[function.first] = [filename, function](const entity& entity, const sol::this_state s, sol::variadic_args va)
 					{
@@ -689,12 +844,13 @@ namespace scripting::lua
 			{
 				sol::state_view state = s;
 
-				if (scripting::script_function_table.find(filename) == scripting::script_function_table.end())
+				const auto* file_functions = scripting::script_function_table.find(filename);
+				if (!file_functions)
 				{
 					throw std::runtime_error("File '" + filename + "' not found");
 				}
 
-				for (const auto& function : scripting::script_function_table[filename])
+				for (const auto& function : *file_functions)
 				{
 					const auto name = utils::string::to_lower(function.first);
 
@@ -876,6 +1032,7 @@ namespace scripting::lua
 		: folder_(std::move(folder))
 		  , scheduler_(state_)
 		  , event_handler_(state_)
+		  , gc_(state_)
 
 	{
 		this->state_.open_libraries(sol::lib::base,
@@ -903,8 +1060,9 @@ namespace scripting::lua
 		};
 
 		remove_unsafe_functions(this->state_);
+		setup_module_loader(this->state_);
 		setup_io(this->state_);
-		setup_json(this->state_);
+		json::setup(this->state_);
 		setup_vector_type(this->state_);
 		setup_debug_funcs(this->state_);
 		setup_entity_type(this->state_, this->event_handler_, this->scheduler_);
@@ -918,6 +1076,7 @@ namespace scripting::lua
 		: folder_({})
 		  , scheduler_(state_)
 		  , event_handler_(state_)
+		  , gc_(state_)
 
 	{
 		this->state_.open_libraries(sol::lib::base,
@@ -937,7 +1096,7 @@ namespace scripting::lua
 		};
 
 		setup_io(this->state_);
-		setup_json(this->state_);
+		json::setup(this->state_);
 		setup_vector_type(this->state_);
 		setup_debug_funcs(this->state_);
 		setup_entity_type(this->state_, this->event_handler_, this->scheduler_);
@@ -977,7 +1136,18 @@ namespace scripting::lua
 	void context::run_frame()
 	{
 		this->scheduler_.run_frame();
-		this->state_.collect_garbage();
+		this->event_handler_.collect_garbage();
+		this->gc_.run_frame();
+	}
+
+	const std::string& context::get_folder() const
+	{
+		return this->folder_;
+	}
+
+	const gc_stats& context::get_gc_stats() const
+	{
+		return this->gc_.get_stats();
 	}
 
 	void context::notify(const event& e)
@@ -991,6 +1161,11 @@ namespace scripting::lua
 		this->event_handler_.handle_endon_conditions(e);
 	}
 
+	bool context::has_event_listeners(const std::string_view event)
+	{
+		return this->event_handler_.has_listeners(event);
+	}
+
 	void context::load_script(const std::string& script)
 	{
 		if (!this->loaded_scripts_.emplace(script).second)
@@ -999,6 +1174,14 @@ namespace scripting::lua
 		}
 
 		const auto file = (std::filesystem::path{this->folder_} / (script + ".lua")).generic_string();
-		handle_error(this->state_.safe_script_file(file, &sol::script_pass_on_error));
+		auto chunk = chunk_cache::load_file(this->state_, file);
+		if (!chunk.valid())
+		{
+			handle_error(chunk);
+			return;
+		}
+
+		const sol::protected_function function = chunk;
+		handle_error(function());
 	}
 }
@@ -11,6 +11,7 @@
 
 #include "scheduler.hpp"
 #include "event_handler.hpp"
+#include "gc_controller.hpp"
 
 namespace scripting::lua
 {
@@ -31,8 +32,13 @@ namespace scripting::lua
 		void notify(const event& e);
 		void handle_endon_conditions(const event& e);
 
+		bool has_event_listeners(std::string_view event);
+
 		std::string load(const std::string& code);
 
+		const std::string& get_folder() const;
+		const gc_stats& get_gc_stats() const;
+
 	private:
 		sol::state state_{};
 		std::string folder_;
@@ -40,6 +46,7 @@ namespace scripting::lua
 
 		scheduler scheduler_;
 		event_handler event_handler_;
+		gc_controller gc_;
 
 		void load_script(const std::string& script);
 	};
@@ -85,6 +85,14 @@ namespace scripting::lua::engine
 		}
 	}
 
+	bool has_event_listeners(const std::string_view event)
+	{
+		return std::ranges::any_of(get_scripts(), [&](const auto& script)
+		{
+			return script->has_event_listeners(event);
+		});
+	}
+
 	std::optional<std::string> load(const std::string& code)
 	{
 		if (get_scripts().size() == 0)
@@ -95,4 +103,16 @@ namespace scripting::lua::engine
 		const auto& script = get_scripts()[0];
 		return {script->load(code)};
 	}
+
+	std::vector<std::pair<std::string, gc_stats>> get_gc_stats()
+	{
+		std::vector<std::pair<std::string, gc_stats>> stats{};
+		for (const auto& script : get_scripts())
+		{
+			const auto& folder = script->get_folder();
+			stats.emplace_back(folder.empty() ? "generic" : folder, script->get_gc_stats());
+		}
+
+		return stats;
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../event.hpp"
+#include "gc_controller.hpp"
 
 namespace scripting::lua::engine
 {
@@ -10,5 +11,9 @@ namespace scripting::lua::engine
 	void handle_endon_conditions(const event& e);
 	void run_frame();
 
+	bool has_event_listeners(std::string_view event);
+
 	std::optional<std::string> load(const std::string& code);
+
+	std::vector<std::pair<std::string, gc_stats>> get_gc_stats();
 }
@@ -18,6 +18,15 @@ namespace scripting::lua
 			{
 			}
 		}
+
+		void print_error(const sol::error& err)
+		{
+			console::error("************** Script execution error **************\n");
+			console::error("%s\n", err.what());
+			console::error("****************************************************\n");
+
+			notify_error();
+		}
 	}
 
 	void handle_error(const sol::protected_function_result& result)
@@ -26,14 +35,23 @@ namespace scripting::lua
 		{
 			try
 			{
-				console::error("************** Script execution error **************\n");
-
 				const sol::error err = result;
-				console::error("%s\n", err.what());
-
-				console::error("****************************************************\n");
+				print_error(err);
+			}
+			catch (...)
+			{
+			}
+		}
+	}
 
-				notify_error();
+	void handle_error(const sol::load_result& result)
+	{
+		if (!result.valid())
+		{
+			try
+			{
+				const sol::error err = result;
+				print_error(err);
 			}
 			catch (...)
 			{
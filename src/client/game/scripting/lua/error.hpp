@@ -5,4 +5,5 @@
 namespace scripting::lua
 {
 	void handle_error(const sol::protected_function_result& result);
+	void handle_error(const sol::load_result& result);
 }
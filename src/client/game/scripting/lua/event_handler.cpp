@@ -23,43 +23,39 @@ namespace scripting::lua
 		};
 	}
 
+	namespace
+	{
+		// Buckets compacted per frame, keeps the cost of removals spread out
+		constexpr auto max_compactions_per_frame = 32;
+
+		using listener_index = utils::listener_index<event_listener>;
+	}
+
 	void event_handler::dispatch(const event& event)
 	{
 		bool has_built_arguments = false;
 		event_arguments arguments{};
 
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
 		{
 			this->merge_callbacks();
 
-			for (auto i = tasks.begin(); i != tasks.end();)
+			index.dispatch(event.name, event.entity.get_entity_id(), [&](event_listener& listener)
 			{
-				if (i->event != event.name || i->entity != event.entity)
+				// Removed before the callback runs, it could dispatch the same event again
+				if (listener.is_volatile)
 				{
-					++i;
-					continue;
+					listener.is_deleted = true;
 				}
 
-				if (!i->is_deleted)
+				if (!has_built_arguments)
 				{
-					if (!has_built_arguments)
-					{
-						has_built_arguments = true;
-						arguments = this->build_arguments(event);
-					}
-
-					handle_error(i->callback(sol::as_args(arguments)));
+					has_built_arguments = true;
+					arguments = this->build_arguments(event);
 				}
 
-				if (i->is_volatile || i->is_deleted)
-				{
-					i = tasks.erase(i);
-				}
-				else
-				{
-					++i;
-				}
-			}
+				handle_error(listener.callback(sol::as_args(arguments)));
+			});
 		});
 	}
 
@@ -80,39 +76,52 @@ namespace scripting::lua
 	void event_handler::add_endon_condition(const event_listener_handle& handle, const entity& entity,
 		const std::string& event)
 	{
-		auto merger = [&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
 		{
-			for (auto& task : tasks)
+			index.add_endon_condition(handle.id, entity, event);
+
+			// Pending listeners get indexed once they are merged
+			new_callbacks_.access([&](task_list& tasks)
 			{
-				if (task.id == handle.id)
+				for (auto& task : tasks)
 				{
-					task.endon_conditions.emplace_back(entity, event);
+					if (task.id == handle.id)
+					{
+						task.endon_conditions.emplace_back(entity, event);
+					}
 				}
-			}
-		};
-
-		callbacks_.access([&](task_list& tasks)
-		{
-			merger(tasks);
-			new_callbacks_.access(merger);
+			});
 		});
 	}
 
 	void event_handler::clear()
 	{
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
 		{
 			new_callbacks_.access([&](task_list& new_tasks)
 			{
 				new_tasks.clear();
-				tasks.clear();
+				index.clear();
 			});
 		});
 	}
 
+	void event_handler::collect_garbage()
+	{
+		callbacks_.access([&](listener_index& index)
+		{
+			index.compact(max_compactions_per_frame);
+		});
+	}
+
 	void event_handler::remove(const event_listener_handle& handle)
 	{
-		auto mask_as_deleted = [&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
+		{
+			index.remove(handle.id);
+		});
+
+		new_callbacks_.access([&](task_list& tasks)
 		{
 			for (auto& task : tasks)
 			{
@@ -122,20 +131,20 @@ namespace scripting::lua
 					break;
 				}
 			}
-		};
-
-		callbacks_.access(mask_as_deleted);
-		new_callbacks_.access(mask_as_deleted);
+		});
 	}
 
 	void event_handler::merge_callbacks()
 	{
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
 		{
 			new_callbacks_.access([&](task_list& new_tasks)
 			{
-				tasks.insert(tasks.end(), std::move_iterator<task_list::iterator>(new_tasks.begin()),
-				             std::move_iterator<task_list::iterator>(new_tasks.end()));
+				for (auto& listener : new_tasks)
+				{
+					index.add(std::move(listener));
+				}
+
 				new_tasks = {};
 			});
 		});
@@ -143,23 +152,21 @@ namespace scripting::lua
 
 	void event_handler::handle_endon_conditions(const event& event)
 	{
-		auto deleter = [&](task_list& tasks)
+		callbacks_.access([&](listener_index& index)
 		{
-			for (auto& task : tasks)
-			{
-				for (auto& condition : task.endon_conditions)
-				{
-					if (condition.first == event.entity && condition.second == event.name)
-					{
-						task.is_deleted = true;
-						break;
-					}
-				}
-			}
-		};
+			// Pending listeners can already have endon conditions, indexing them keeps this a lookup
+			this->merge_callbacks();
+			index.handle_endon_conditions(event.entity.get_entity_id(), event.name);
+		});
+	}
 
-		callbacks_.access(deleter);
-		new_callbacks_.access(deleter);
+	bool event_handler::has_listeners(const std::string_view event)
+	{
+		return callbacks_.access<bool>([&](listener_index& index)
+		{
+			this->merge_callbacks();
+			return index.has_listeners(event);
+		});
 	}
 
 	event_arguments event_handler::build_arguments(const event& event) const
@@ -1,5 +1,6 @@
 #pragma once
 #include <utils/concurrency.hpp>
+#include <utils/listener_index.hpp>
 
 namespace scripting::lua
 {
@@ -42,13 +43,19 @@ namespace scripting::lua
 
 		void handle_endon_conditions(const event& event);
 
+		// Lets notifies be skipped before their arguments are captured
+		bool has_listeners(std::string_view event);
+
+		void collect_garbage();
+
 	private:
 		sol::state& state_;
 		std::atomic_int64_t current_listener_id_ = 0;
 
 		using task_list = std::vector<event_listener>;
+
 		utils::concurrency::container<task_list> new_callbacks_;
-		utils::concurrency::container<task_list, std::recursive_mutex> callbacks_;
+		utils::concurrency::container<utils::listener_index<event_listener>, std::recursive_mutex> callbacks_;
 
 		void remove(const event_listener_handle& handle);
 		void merge_callbacks();
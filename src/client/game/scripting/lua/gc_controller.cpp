@@ -0,0 +1,40 @@
+#include <std_include.hpp>
+#include "gc_controller.hpp"
+#include "context.hpp"
+
+#include "game/dvars.hpp"
+
+namespace scripting::lua
+{
+	std::chrono::microseconds get_gc_budget()
+	{
+		if (!dvars::lua_gcBudget)
+		{
+			return 500us;
+		}
+
+		return std::chrono::microseconds{dvars::lua_gcBudget->current.integer};
+	}
+
+	gc_controller::gc_controller(lua_State* state)
+		: state_(state)
+	{
+	}
+
+	void gc_controller::run_frame()
+	{
+		run_gc_steps(this->stats_, [this]()
+		{
+			return lua_gc(this->state_, LUA_GCSTEP, 0) != 0;
+		});
+
+		const auto kilobytes = static_cast<size_t>(lua_gc(this->state_, LUA_GCCOUNT));
+		const auto bytes = static_cast<size_t>(lua_gc(this->state_, LUA_GCCOUNTB));
+		this->stats_.heap_size = (kilobytes << 10) + bytes;
+	}
+
+	const gc_stats& gc_controller::get_stats() const
+	{
+		return this->stats_;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+struct lua_State;
+
+namespace scripting::lua
+{
+	struct gc_stats
+	{
+		std::chrono::microseconds frame_time{};
+		std::chrono::microseconds max_frame_time{};
+		std::chrono::microseconds total_time{};
+		uint64_t steps{};
+		uint64_t cycles{};
+		size_t heap_size{};
+	};
+
+	std::chrono::microseconds get_gc_budget();
+
+	// Runs incremental collector steps until the frame budget from lua_gcBudget is spent
+	// or a cycle completes. The step function returns true once it finished a cycle
+	template <typename F>
+	void run_gc_steps(gc_stats& stats, F&& step)
+	{
+		stats.frame_time = {};
+
+		const auto budget = get_gc_budget();
+		if (budget <= std::chrono::microseconds::zero())
+		{
+			return;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		do
+		{
+			++stats.steps;
+			if (step())
+			{
+				++stats.cycles;
+				stats.frame_time = std::chrono::duration_cast<std::chrono::microseconds>(
+					std::chrono::high_resolution_clock::now() - start);
+				break;
+			}
+
+			stats.frame_time = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::high_resolution_clock::now() - start);
+		}
+		while (stats.frame_time < budget);
+
+		stats.max_frame_time = std::max(stats.max_frame_time, stats.frame_time);
+		stats.total_time += stats.frame_time;
+	}
+
+	class gc_controller final
+	{
+	public:
+		gc_controller(lua_State* state);
+
+		void run_frame();
+		const gc_stats& get_stats() const;
+
+	private:
+		lua_State* state_;
+		gc_stats stats_{};
+	};
+}
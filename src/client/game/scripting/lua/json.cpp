@@ -0,0 +1,383 @@
+#include <std_include.hpp>
+#include "json.hpp"
+
+#include "component/filesystem.hpp"
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/writer.h>
+
+#include <utils/io.hpp>
+
+namespace scripting::lua::json
+{
+	namespace
+	{
+		using writer_t = rapidjson::Writer<rapidjson::StringBuffer>;
+
+		void encode_value(lua_State* state, int index, writer_t& writer, std::vector<const void*>& tables);
+
+		// Same rules as the Lua implementation: tables with a first element or no elements at all
+		// are arrays and must not be sparse, all other tables need string keys
+		void encode_table(lua_State* state, const int index, writer_t& writer, std::vector<const void*>& tables)
+		{
+			const auto* pointer = lua_topointer(state, index);
+			if (std::find(tables.begin(), tables.end(), pointer) != tables.end())
+			{
+				throw std::runtime_error("circular reference");
+			}
+
+			if (!lua_checkstack(state, 3))
+			{
+				throw std::runtime_error("table too deep");
+			}
+
+			tables.push_back(pointer);
+
+			lua_rawgeti(state, index, 1);
+			auto is_array = !lua_isnil(state, -1);
+			lua_pop(state, 1);
+
+			if (!is_array)
+			{
+				lua_pushnil(state);
+				if (lua_next(state, index))
+				{
+					lua_pop(state, 2);
+				}
+				else
+				{
+					is_array = true;
+				}
+			}
+
+			if (is_array)
+			{
+				size_t count = 0;
+
+				lua_pushnil(state);
+				while (lua_next(state, index))
+				{
+					if (lua_type(state, -2) != LUA_TNUMBER)
+					{
+						throw std::runtime_error("invalid table: mixed or invalid key types");
+					}
+
+					++count;
+					lua_pop(state, 1);
+				}
+
+				const auto length = lua_rawlen(state, index);
+				if (count != length)
+				{
+					throw std::runtime_error("invalid table: sparse array");
+				}
+
+				writer.StartArray();
+
+				for (size_t i = 1; i <= length; ++i)
+				{
+					lua_rawgeti(state, index, static_cast<lua_Integer>(i));
+					encode_value(state, lua_gettop(state), writer, tables);
+					lua_pop(state, 1);
+				}
+
+				writer.EndArray();
+			}
+			else
+			{
+				writer.StartObject();
+
+				lua_pushnil(state);
+				while (lua_next(state, index))
+				{
+					if (lua_type(state, -2) != LUA_TSTRING)
+					{
+						throw std::runtime_error("invalid table: mixed or invalid key types");
+					}
+
+					size_t length = 0;
+					const auto* key = lua_tolstring(state, -2, &length);
+					writer.Key(key, static_cast<rapidjson::SizeType>(length));
+
+					encode_value(state, lua_gettop(state), writer, tables);
+					lua_pop(state, 1);
+				}
+
+				writer.EndObject();
+			}
+
+			tables.pop_back();
+		}
+
+		void encode_value(lua_State* state, const int index, writer_t& writer, std::vector<const void*>& tables)
+		{
+			switch (lua_type(state, index))
+			{
+			case LUA_TNIL:
+				writer.Null();
+				break;
+			case LUA_TBOOLEAN:
+				writer.Bool(lua_toboolean(state, index));
+				break;
+			case LUA_TNUMBER:
+				if (lua_isinteger(state, index))
+				{
+					writer.Int64(lua_tointeger(state, index));
+				}
+				else
+				{
+					const auto value = lua_tonumber(state, index);
+					if (!std::isfinite(value))
+					{
+						throw std::runtime_error(std::format("unexpected number value '{}'", value));
+					}
+
+					writer.Double(value);
+				}
+				break;
+			case LUA_TSTRING:
+			{
+				size_t length = 0;
+				const auto* value = lua_tolstring(state, index, &length);
+				writer.String(value, static_cast<rapidjson::SizeType>(length));
+				break;
+			}
+			case LUA_TTABLE:
+				encode_table(state, index, writer, tables);
+				break;
+			default:
+				throw std::runtime_error(std::format("unexpected type '{}'", luaL_typename(state, index)));
+			}
+		}
+
+		// Builds the Lua values straight from the parser events, without an intermediate document
+		class decode_handler final : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, decode_handler>
+		{
+		public:
+			explicit decode_handler(lua_State* state)
+				: state_(state)
+			{
+			}
+
+			bool Null()
+			{
+				// Like the Lua implementation, null becomes nil and keeps its slot in arrays
+				if (this->frames_.empty())
+				{
+					lua_pushnil(this->state_);
+				}
+				else if (this->frames_.back().is_array)
+				{
+					++this->frames_.back().next_index;
+				}
+				else
+				{
+					lua_pop(this->state_, 1);
+				}
+
+				return true;
+			}
+
+			bool Bool(const bool value)
+			{
+				lua_pushboolean(this->state_, value);
+				return this->add_value();
+			}
+
+			bool Int(const int value)
+			{
+				return this->Int64(value);
+			}
+
+			bool Uint(const unsigned value)
+			{
+				return this->Int64(value);
+			}
+
+			bool Int64(const int64_t value)
+			{
+				lua_pushinteger(this->state_, value);
+				return this->add_value();
+			}
+
+			bool Uint64(const uint64_t value)
+			{
+				if (value > static_cast<uint64_t>(std::numeric_limits<lua_Integer>::max()))
+				{
+					return this->Double(static_cast<double>(value));
+				}
+
+				return this->Int64(static_cast<int64_t>(value));
+			}
+
+			bool Double(const double value)
+			{
+				lua_pushnumber(this->state_, value);
+				return this->add_value();
+			}
+
+			bool String(const char* value, const rapidjson::SizeType length, bool)
+			{
+				lua_pushlstring(this->state_, value, length);
+				return this->add_value();
+			}
+
+			bool Key(const char* value, const rapidjson::SizeType length, bool)
+			{
+				lua_pushlstring(this->state_, value, length);
+				return true;
+			}
+
+			bool StartObject()
+			{
+				return this->begin_table(false);
+			}
+
+			bool EndObject(rapidjson::SizeType)
+			{
+				return this->end_table();
+			}
+
+			bool StartArray()
+			{
+				return this->begin_table(true);
+			}
+
+			bool EndArray(rapidjson::SizeType)
+			{
+				return this->end_table();
+			}
+
+		private:
+			struct frame
+			{
+				bool is_array;
+				lua_Integer next_index;
+			};
+
+			lua_State* state_;
+			std::vector<frame> frames_;
+
+			bool begin_table(const bool is_array)
+			{
+				// Room for the table, a pending key and its value
+				if (!lua_checkstack(this->state_, 3))
+				{
+					return false;
+				}
+
+				lua_newtable(this->state_);
+				this->frames_.push_back({is_array, 1});
+				return true;
+			}
+
+			bool end_table()
+			{
+				this->frames_.pop_back();
+				return this->add_value();
+			}
+
+			bool add_value()
+			{
+				if (this->frames_.empty())
+				{
+					return true;
+				}
+
+				auto& frame = this->frames_.back();
+				if (frame.is_array)
+				{
+					lua_rawseti(this->state_, -2, frame.next_index++);
+				}
+				else
+				{
+					lua_rawset(this->state_, -3);
+				}
+
+				return true;
+			}
+		};
+
+		sol::object decode_stream(lua_State* state, rapidjson::MemoryStream& stream)
+		{
+			const auto top = lua_gettop(state);
+
+			decode_handler handler{state};
+			rapidjson::Reader reader{};
+
+			const auto result = reader.Parse<rapidjson::kParseIterativeFlag>(stream, handler);
+			if (result.IsError())
+			{
+				lua_settop(state, top);
+				throw std::runtime_error(std::format("{} at character {}",
+					rapidjson::GetParseError_En(result.Code()), result.Offset() + 1));
+			}
+
+			sol::object value{state, -1};
+			lua_settop(state, top);
+			return value;
+		}
+	}
+
+	std::string encode(lua_State* state, const sol::object& value)
+	{
+		const auto top = lua_gettop(state);
+		const auto _ = gsl::finally([&]()
+		{
+			lua_settop(state, top);
+		});
+
+		rapidjson::StringBuffer buffer{};
+		writer_t writer{buffer};
+		std::vector<const void*> tables{};
+
+		value.push(state);
+		encode_value(state, lua_gettop(state), writer, tables);
+
+		return {buffer.GetString(), buffer.GetSize()};
+	}
+
+	sol::object decode(lua_State* state, const std::string_view data)
+	{
+		rapidjson::MemoryStream stream{data.data(), data.size()};
+		return decode_stream(state, stream);
+	}
+
+	sol::object decode_file(lua_State* state, const std::string& path)
+	{
+		const utils::io::mapped_file file{filesystem::get_safe_path(path)};
+		if (!file.is_valid())
+		{
+			throw std::runtime_error(std::format("Could not read file '{}'", path));
+		}
+
+		// Parsed straight from the mapping, the file never becomes a Lua string
+		const auto data = file.get_view();
+		rapidjson::MemoryStream stream{data.data(), data.size()};
+		return decode_stream(state, stream);
+	}
+
+	void setup(sol::state& state)
+	{
+		auto json = sol::table::create(state.lua_state());
+		json["_version"] = "native";
+
+		json["encode"] = [](const sol::this_state s, const sol::object& value)
+		{
+			return encode(s, value);
+		};
+
+		json["decode"] = [](const sol::this_state s, const std::string_view data)
+		{
+			return decode(s, data);
+		};
+
+		json["decodefile"] = [](const sol::this_state s, const std::string& path)
+		{
+			return decode_file(s, path);
+		};
+
+		state["json"] = json;
+	}
+}
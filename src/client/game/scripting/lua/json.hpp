@@ -0,0 +1,12 @@
+#pragma once
+
+#include "context.hpp"
+
+namespace scripting::lua::json
+{
+	std::string encode(lua_State* state, const sol::object& value);
+	sol::object decode(lua_State* state, std::string_view data);
+	sol::object decode_file(lua_State* state, const std::string& path);
+
+	void setup(sol::state& state);
+}
@@ -21,34 +21,37 @@ namespace scripting::lua
 
 	void scheduler::dispatch(const event& event)
 	{
-		auto deleter = [&](task_list& tasks)
+		callbacks_.access([&](task_queue& queue)
 		{
-			for (auto& task : tasks)
+			const auto entity_conditions = queue.endon_conditions.find(event.entity.get_entity_id());
+			if (entity_conditions == queue.endon_conditions.end())
 			{
-				for (auto& condition : task.endon_conditions)
-				{
-					if (condition.first == event.entity && condition.second == event.name)
-					{
-						task.is_deleted = true;
-						break;
-					}
-				}
+				return;
 			}
-		};
 
-		callbacks_.access([&](task_list& tasks)
-		{
-			deleter(tasks);
-			new_callbacks_.access(deleter);
+			const auto conditions = entity_conditions->second.find(event.name);
+			if (conditions == entity_conditions->second.end())
+			{
+				return;
+			}
+
+			queue.ended_tasks.insert(conditions->second.begin(), conditions->second.end());
+
+			entity_conditions->second.erase(conditions);
+			if (entity_conditions->second.empty())
+			{
+				queue.endon_conditions.erase(entity_conditions);
+			}
 		});
 	}
 
 	void scheduler::run_frame()
 	{
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](task_queue& queue)
 		{
 			this->merge_callbacks();
 
+			auto& tasks = queue.tasks;
 			for (auto i = tasks.begin(); i != tasks.end();)
 			{
 				const auto now = *game::gameTime;
@@ -62,6 +65,11 @@ namespace scripting::lua
 
 				i->last_call = now;
 
+				if (!i->is_deleted && queue.ended_tasks.contains(i->id))
+				{
+					i->is_deleted = true;
+				}
+
 				if (!i->is_deleted)
 				{
 					handle_error(i->callback());
@@ -69,6 +77,7 @@ namespace scripting::lua
 
 				if (i->is_volatile || i->is_deleted)
 				{
+					remove_endon_conditions(queue, *i);
 					i = tasks.erase(i);
 				}
 				else
@@ -81,12 +90,12 @@ namespace scripting::lua
 
 	void scheduler::clear()
 	{
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](task_queue& queue)
 		{
 			new_callbacks_.access([&](task_list& new_tasks)
 			{
 				new_tasks.clear();
-				tasks.clear();
+				queue = {};
 			});
 		});
 	}
@@ -127,17 +136,55 @@ namespace scripting::lua
 				if (task.id == handle.id)
 				{
 					task.endon_conditions.emplace_back(entity, event);
+					return true;
 				}
 			}
+
+			return false;
 		};
 
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](task_queue& queue)
 		{
-			merger(tasks);
-			new_callbacks_.access(merger);
+			const auto found = merger(queue.tasks) || new_callbacks_.access<bool>(merger);
+			if (found)
+			{
+				queue.endon_conditions[entity.get_entity_id()][event].emplace_back(handle.id);
+			}
 		});
 	}
 
+	void scheduler::remove_endon_conditions(task_queue& queue, const task& task)
+	{
+		queue.ended_tasks.erase(task.id);
+
+		for (const auto& condition : task.endon_conditions)
+		{
+			const auto entity_conditions = queue.endon_conditions.find(condition.first.get_entity_id());
+			if (entity_conditions == queue.endon_conditions.end())
+			{
+				continue;
+			}
+
+			const auto conditions = entity_conditions->second.find(condition.second);
+			if (conditions == entity_conditions->second.end())
+			{
+				continue;
+			}
+
+			std::erase(conditions->second, task.id);
+
+			if (conditions->second.empty())
+			{
+				entity_conditions->second.erase(conditions);
+			}
+
+			if (entity_conditions->second.empty())
+			{
+				queue.endon_conditions.erase(entity_conditions);
+			}
+		}
+	}
+
 	void scheduler::remove(const task_handle& handle)
 	{
 		auto mask_as_deleted = [&](task_list& tasks)
@@ -152,16 +199,21 @@ namespace scripting::lua
 			}
 		};
 
-		callbacks_.access(mask_as_deleted);
+		callbacks_.access([&](task_queue& queue)
+		{
+			mask_as_deleted(queue.tasks);
+		});
+
 		new_callbacks_.access(mask_as_deleted);
 	}
 
 	void scheduler::merge_callbacks()
 	{
-		callbacks_.access([&](task_list& tasks)
+		callbacks_.access([&](task_queue& queue)
 		{
 			new_callbacks_.access([&](task_list& new_tasks)
 			{
+				auto& tasks = queue.tasks;
 				tasks.insert(tasks.end(), std::move_iterator<task_list::iterator>(new_tasks.begin()),
 				             std::move_iterator<task_list::iterator>(new_tasks.end()));
 				new_tasks = {};
@@ -42,11 +42,23 @@ namespace scripting::lua
 
 	private:
 		using task_list = std::vector<task>;
+
+		// Task ids waiting on a notify, keyed by entity id and event name
+		using endon_index = std::unordered_map<unsigned int, std::unordered_map<std::string, std::vector<uint64_t>>>;
+
+		struct task_queue
+		{
+			task_list tasks;
+			endon_index endon_conditions;
+			std::unordered_set<uint64_t> ended_tasks;
+		};
+
 		utils::concurrency::container<task_list> new_callbacks_;
-		utils::concurrency::container<task_list, std::recursive_mutex> callbacks_;
+		utils::concurrency::container<task_queue, std::recursive_mutex> callbacks_;
 		std::atomic_int64_t current_task_id_ = 0;
 
 		void add_endon_condition(const task_handle& handle, const entity& entity, const std::string& event);
+		static void remove_endon_conditions(task_queue& queue, const task& task);
 
 		void remove(const task_handle& handle);
 		void merge_callbacks();
@@ -78,6 +78,7 @@
 #include <optional>
 #include <unordered_set>
 #include <variant>
+#include <future>
 
 #include <gsl/gsl>
 #include <udis86.h>
@@ -6,89 +6,156 @@
 
 #include <gsl/gsl>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <thread>
+
 #include "io.hpp"
 
 namespace utils::compression
 {
 	namespace zlib
 	{
-		namespace
+		inflater::inflater()
+			: stream_(std::make_unique<z_stream>())
+		{
+			this->valid_ = inflateInit(this->stream_.get()) == Z_OK;
+		}
+
+		inflater::~inflater()
 		{
-			class zlib_stream
+			if (this->valid_)
 			{
-			public:
-				zlib_stream()
-				{
-					memset(&stream_, 0, sizeof(stream_));
-					valid_ = inflateInit(&stream_) == Z_OK;
-				}
+				inflateEnd(this->stream_.get());
+			}
+		}
 
-				zlib_stream(zlib_stream&&) = delete;
-				zlib_stream(const zlib_stream&) = delete;
-				zlib_stream& operator=(zlib_stream&&) = delete;
-				zlib_stream& operator=(const zlib_stream&) = delete;
+		bool inflater::process(std::span<const std::uint8_t>& input, std::span<std::uint8_t>& output)
+		{
+			if (!this->valid_)
+			{
+				return false;
+			}
 
-				~zlib_stream()
-				{
-					if (valid_)
-					{
-						inflateEnd(&stream_);
-					}
-				}
+			if (this->done_)
+			{
+				return true;
+			}
 
-				z_stream& get()
-				{
-					return stream_; //
-				}
+			auto& stream = *this->stream_;
 
-				bool is_valid() const
-				{
-					return valid_;
-				}
+			// avail_in/avail_out are 32 bit, larger spans are processed over multiple calls
+			stream.next_in = input.data();
+			stream.avail_in = static_cast<uInt>(std::min(input.size(), size_t(std::numeric_limits<uInt>::max())));
+			stream.next_out = output.data();
+			stream.avail_out = static_cast<uInt>(std::min(output.size(), size_t(std::numeric_limits<uInt>::max())));
 
-			private:
-				bool valid_{false};
-				z_stream stream_{};
-			};
+			const auto in_size = stream.avail_in;
+			const auto out_size = stream.avail_out;
+
+			const auto ret = inflate(&stream, Z_NO_FLUSH);
+
+			input = input.subspan(in_size - stream.avail_in);
+			output = output.subspan(out_size - stream.avail_out);
+
+			if (ret == Z_STREAM_END)
+			{
+				this->done_ = true;
+				return true;
+			}
+
+			// Z_BUF_ERROR only means no progress was possible, the caller provides more input or output
+			return ret == Z_OK || ret == Z_BUF_ERROR;
+		}
+
+		bool inflater::is_valid() const
+		{
+			return this->valid_;
+		}
+
+		bool inflater::is_done() const
+		{
+			return this->done_;
+		}
+
+		size_t inflater::get_total_out() const
+		{
+			return this->stream_->total_out;
 		}
 
 		std::string decompress(const std::string& data)
 		{
-			std::string buffer{};
-			zlib_stream stream_container{};
-			if (!stream_container.is_valid())
+			inflater stream{};
+			if (!stream.is_valid())
 			{
 				return {};
 			}
 
-			int ret{};
-			size_t offset = 0;
-			static thread_local uint8_t dest[CHUNK] = {0};
-			auto& stream = stream_container.get();
+			std::span input{reinterpret_cast<const std::uint8_t*>(data.data()), data.size()};
+
+			std::string buffer{};
+			size_t size = 0;
 
-			do
+			while (!stream.is_done())
 			{
-				const auto input_size = std::min(sizeof(dest), data.size() - offset);
-				stream.avail_in = static_cast<uInt>(input_size);
-				stream.next_in = reinterpret_cast<const Bytef*>(data.data()) + offset;
-				offset += stream.avail_in;
+				if (size == buffer.size())
+				{
+					buffer.resize(std::max({size_t(CHUNK), data.size() * 2, buffer.size() * 2}));
+				}
+
+				std::span output{reinterpret_cast<std::uint8_t*>(buffer.data()) + size, buffer.size() - size};
+				const auto available = output.size();
 
-				do
+				if (!stream.process(input, output))
 				{
-					stream.avail_out = sizeof(dest);
-					stream.next_out = dest;
+					return {};
+				}
 
-					ret = inflate(&stream, Z_NO_FLUSH);
-					if (ret != Z_OK && ret != Z_STREAM_END)
-					{
-						return {};
-					}
+				size += available - output.size();
 
-					buffer.insert(buffer.end(), dest, dest + sizeof(dest) - stream.avail_out);
+				// Out of input with room left in the output means the stream is truncated
+				if (!stream.is_done() && input.empty() && !output.empty())
+				{
+					return {};
+				}
+			}
+
+			buffer.resize(size);
+			return buffer;
+		}
+
+		bool decompress_into(std::span<const std::uint8_t> data, std::span<std::uint8_t> output)
+		{
+			inflater stream{};
+
+			while (!stream.is_done())
+			{
+				const auto input_size = data.size();
+				const auto output_size = output.size();
+
+				if (!stream.process(data, output))
+				{
+					return false;
+				}
+
+				if (!stream.is_done() && data.size() == input_size && output.size() == output_size)
+				{
+					return false;
 				}
-				while (stream.avail_out == 0);
 			}
-			while (ret != Z_STREAM_END);
+
+			return output.empty();
+		}
+
+		std::vector<std::uint8_t> decompress(std::span<const std::uint8_t> data, const size_t expected_size)
+		{
+			std::vector<std::uint8_t> buffer(expected_size);
+			if (!decompress_into(data, buffer))
+			{
+				return {};
+			}
 
 			return buffer;
 		}
@@ -115,31 +182,271 @@ namespace utils::compression
 	{
 		namespace
 		{
-			bool add_file(zipFile& zip_file, const std::string& filename, const std::string& data)
+			// Entries are deflated in independent blocks so even a single large file
+			// can be compressed on all cores. Each block is primed with the tail of the
+			// previous one, which keeps the ratio close to a single stream.
+			constexpr size_t block_size = 0x100000;
+			constexpr size_t dictionary_size = 0x8000;
+
+			struct compressed_block
+			{
+				std::string data;
+				uLong crc{};
+			};
+
+			struct compressed_entry
+			{
+				const std::string* filename{};
+				std::string loaded_data;
+				std::span<const std::uint8_t> data;
+				std::vector<compressed_block> blocks;
+				bool valid{true};
+			};
+
+			struct block_job
+			{
+				compressed_entry* entry;
+				size_t index;
+			};
+
+			void run_parallel(const size_t count, const bool parallel, const std::function<void(size_t)>& job)
 			{
-				const auto zip_64 = data.size() > 0xffffffff ? 1 : 0;
-				if (ZIP_OK != zipOpenNewFileInZip64(zip_file, filename.data(), nullptr, nullptr, 0, nullptr, 0, nullptr,
-				                                    Z_DEFLATED, Z_BEST_COMPRESSION, zip_64))
+				const auto max_threads = parallel ? size_t(std::max(1u, std::thread::hardware_concurrency())) : size_t(1);
+				const auto thread_count = std::min(max_threads, count);
+				std::atomic<size_t> next = 0;
+
+				const auto worker = [&]()
+				{
+					for (auto i = next++; i < count; i = next++)
+					{
+						job(i);
+					}
+				};
+
+				std::vector<std::thread> threads;
+				for (size_t i = 1; i < thread_count; ++i)
+				{
+					threads.emplace_back(worker);
+				}
+
+				worker();
+
+				for (auto& thread : threads)
+				{
+					if (thread.joinable())
+					{
+						thread.join();
+					}
+				}
+			}
+
+			bool deflate_block(const std::span<const std::uint8_t> dictionary, const std::span<const std::uint8_t> input,
+			                   const bool last, const int level, compressed_block& block)
+			{
+				z_stream stream{};
+				if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
 				{
 					return false;
 				}
 
-				const auto _ = gsl::finally([&zip_file]()
+				const auto _ = gsl::finally([&stream]()
 				{
-					zipCloseFileInZip(zip_file);
+					deflateEnd(&stream);
 				});
 
-				return ZIP_OK == zipWriteInFileInZip(zip_file, data.data(), static_cast<unsigned>(data.size()));
+				if (!dictionary.empty() && deflateSetDictionary(&stream, dictionary.data(),
+				                                                static_cast<uInt>(dictionary.size())) != Z_OK)
+				{
+					return false;
+				}
+
+				// Leave room for the sync flush marker on top of the regular bound
+				block.data.resize(deflateBound(&stream, static_cast<uLong>(input.size())) + 16);
+
+				stream.next_in = input.data();
+				stream.avail_in = static_cast<uInt>(input.size());
+
+				// Sync flushes end every block on a byte boundary, so the blocks can simply be concatenated
+				const auto flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+
+				while (true)
+				{
+					// The bound should always suffice, but a full buffer must never cut the block short
+					if (stream.total_out == block.data.size())
+					{
+						block.data.resize(block.data.size() * 2);
+					}
+
+					stream.next_out = reinterpret_cast<Bytef*>(block.data.data()) + stream.total_out;
+					stream.avail_out = static_cast<uInt>(block.data.size() - stream.total_out);
+
+					const auto ret = deflate(&stream, flush);
+					if (ret == Z_STREAM_END)
+					{
+						break;
+					}
+
+					// No progress was possible. Either the output is full and grows on the next iteration,
+					// or a sync flush that exactly filled the previous buffer had nothing left to write
+					if (ret == Z_BUF_ERROR)
+					{
+						if (stream.avail_out == 0)
+						{
+							continue;
+						}
+
+						if (!last && stream.avail_in == 0)
+						{
+							break;
+						}
+
+						return false;
+					}
+
+					if (ret != Z_OK)
+					{
+						return false;
+					}
+
+					// A sync flush is complete once all input is consumed and the output didn't fill up
+					if (!last && stream.avail_in == 0 && stream.avail_out != 0)
+					{
+						break;
+					}
+				}
+
+				block.data.resize(stream.total_out);
+				block.crc = crc32(0, input.data(), static_cast<uInt>(input.size()));
+
+				return true;
+			}
+
+			bool write_entry(zipFile& zip_file, const std::string& filename, const compressed_entry& entry, const int level)
+			{
+				uLong crc = crc32(0, nullptr, 0);
+				size_t offset = 0;
+
+				for (const auto& block : entry.blocks)
+				{
+					const auto size = std::min(block_size, entry.data.size() - offset);
+					crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(size));
+					offset += size;
+				}
+
+				const auto zip_64 = entry.data.size() > 0xffffffff ? 1 : 0;
+				if (ZIP_OK != zipOpenNewFileInZip2_64(zip_file, filename.data(), nullptr, nullptr, 0, nullptr, 0, nullptr,
+				                                      Z_DEFLATED, level, 1, zip_64))
+				{
+					return false;
+				}
+
+				auto result = true;
+				for (const auto& block : entry.blocks)
+				{
+					if (ZIP_OK != zipWriteInFileInZip(zip_file, block.data.data(), static_cast<unsigned>(block.data.size())))
+					{
+						result = false;
+						break;
+					}
+				}
+
+				return zipCloseFileInZipRaw64(zip_file, entry.data.size(), crc) == ZIP_OK && result;
 			}
 		}
 
+		archive::archive(const int level, const bool parallel)
+			: level_(level)
+			  , parallel_(parallel)
+		{
+		}
+
 		void archive::add(std::string filename, std::string data)
 		{
 			this->files_[std::move(filename)] = std::move(data);
 		}
 
+		void archive::add(std::string filename, const std::span<const std::uint8_t> data)
+		{
+			this->files_[std::move(filename)] = data;
+		}
+
+		void archive::add_file(std::string filename, std::filesystem::path path)
+		{
+			this->files_[std::move(filename)] = std::move(path);
+		}
+
 		bool archive::write(const std::string& filename, const std::string& comment)
 		{
+			std::vector<compressed_entry> entries(this->files_.size());
+
+			{
+				auto entry = entries.begin();
+				for (const auto& file : this->files_)
+				{
+					(entry++)->filename = &file.first;
+				}
+			}
+
+			run_parallel(entries.size(), this->parallel_, [&](const size_t index)
+			{
+				auto& entry = entries[index];
+				const auto& source = this->files_.at(*entry.filename);
+
+				if (const auto* data = std::get_if<std::string>(&source))
+				{
+					entry.data = {reinterpret_cast<const std::uint8_t*>(data->data()), data->size()};
+				}
+				else if (const auto* span = std::get_if<std::span<const std::uint8_t>>(&source))
+				{
+					entry.data = *span;
+				}
+				else if (const auto* path = std::get_if<std::filesystem::path>(&source))
+				{
+					entry.valid = io::read_file(path->generic_string(), &entry.loaded_data);
+					entry.data = {reinterpret_cast<const std::uint8_t*>(entry.loaded_data.data()), entry.loaded_data.size()};
+				}
+
+				entry.blocks.resize(std::max(size_t(1), (entry.data.size() + block_size - 1) / block_size));
+			});
+
+			std::vector<block_job> jobs;
+			for (auto& entry : entries)
+			{
+				if (!entry.valid)
+				{
+					return false;
+				}
+
+				for (size_t i = 0; i < entry.blocks.size(); ++i)
+				{
+					jobs.push_back({&entry, i});
+				}
+			}
+
+			std::atomic<bool> compressed = true;
+
+			run_parallel(jobs.size(), this->parallel_, [&](const size_t index)
+			{
+				const auto& job = jobs[index];
+				auto& entry = *job.entry;
+
+				const auto offset = job.index * block_size;
+				const auto input = entry.data.subspan(offset, std::min(block_size, entry.data.size() - offset));
+				const auto dictionary = entry.data.subspan(offset - std::min(offset, dictionary_size),
+				                                           std::min(offset, dictionary_size));
+				const auto last = job.index + 1 == entry.blocks.size();
+
+				if (!deflate_block(dictionary, input, last, this->level_, entry.blocks[job.index]))
+				{
+					compressed = false;
+				}
+			});
+
+			if (!compressed)
+			{
+				return false;
+			}
+
 			// Hack to create the directory :3
 			io::write_file(filename, {});
 			io::remove_file(filename);
@@ -155,9 +462,9 @@ namespace utils::compression
 				zipClose(zip_file, comment.empty() ? nullptr : comment.data());
 			});
 
-			for (const auto& file : this->files_)
+			for (const auto& entry : entries)
 			{
-				if (!add_file(zip_file, file.first, file.second))
+				if (!write_entry(zip_file, *entry.filename, entry, this->level_))
 				{
 					return false;
 				}
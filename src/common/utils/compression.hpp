@@ -1,16 +1,52 @@
 #pragma once
 
+#include <filesystem>
+#include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <variant>
+#include <vector>
 
 #define CHUNK 16384u
 
+struct z_stream_s;
+
 namespace utils::compression
 {
 	namespace zlib
 	{
+		class inflater final
+		{
+		public:
+			inflater();
+			~inflater();
+
+			inflater(inflater&&) = delete;
+			inflater(const inflater&) = delete;
+			inflater& operator=(inflater&&) = delete;
+			inflater& operator=(const inflater&) = delete;
+
+			// Consumes as much input as fits into output, both spans are advanced past
+			// the processed data. Returns false if the stream is corrupt.
+			bool process(std::span<const std::uint8_t>& input, std::span<std::uint8_t>& output);
+
+			bool is_valid() const;
+			bool is_done() const;
+			size_t get_total_out() const;
+
+		private:
+			bool valid_{false};
+			bool done_{false};
+			std::unique_ptr<z_stream_s> stream_;
+		};
+
 		std::string compress(const std::string& data);
 		std::string decompress(const std::string& data);
+
+		// Decompresses exactly output.size() bytes without any intermediate buffers
+		bool decompress_into(std::span<const std::uint8_t> data, std::span<std::uint8_t> output);
+		std::vector<std::uint8_t> decompress(std::span<const std::uint8_t> data, size_t expected_size);
 	}
 
 	namespace zip
@@ -18,11 +54,26 @@ namespace utils::compression
 		class archive
 		{
 		public:
+			archive() = default;
+			explicit archive(int level, bool parallel = true);
+
 			void add(std::string filename, std::string data);
+
+			// The data is only referenced, it must stay alive until the archive is written
+			void add(std::string filename, std::span<const std::uint8_t> data);
+
+			// The file is read when the archive is written
+			void add_file(std::string filename, std::filesystem::path path);
+
+			// Entries are compressed in parallel unless disabled and written to the archive sequentially
 			bool write(const std::string& filename, const std::string& comment = {});
 
 		private:
-			std::unordered_map<std::string, std::string> files_;
+			using entry = std::variant<std::string, std::span<const std::uint8_t>, std::filesystem::path>;
+
+			int level_{9};
+			bool parallel_{true};
+			std::unordered_map<std::string, entry> files_;
 		};
 	}
 };
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 
 namespace utils::concurrency
@@ -43,4 +45,70 @@ namespace utils::concurrency
 		mutable MutexType mutex_{};
 		T object_{};
 	};
+
+	// Multi-producer single-consumer queue. Producers never block,
+	// the consumer takes everything that was pushed so far in one go.
+	template <typename T>
+	class mpsc_queue
+	{
+	public:
+		mpsc_queue() = default;
+
+		~mpsc_queue()
+		{
+			this->drain([](T&&)
+			{
+			});
+		}
+
+		mpsc_queue(const mpsc_queue&) = delete;
+		mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+		void push(T&& value)
+		{
+			auto* node = new node_t{std::move(value), head_.load(std::memory_order_relaxed)};
+			while (!head_.compare_exchange_weak(node->next, node, std::memory_order_release,
+			                                    std::memory_order_relaxed))
+			{
+			}
+		}
+
+		// Calls the accessor for every element in push order
+		template <typename F>
+		void drain(F&& accessor)
+		{
+			auto* node = head_.exchange(nullptr, std::memory_order_acquire);
+
+			// The list is linked newest first
+			node_t* ordered = nullptr;
+			while (node)
+			{
+				auto* next = node->next;
+				node->next = ordered;
+				ordered = node;
+				node = next;
+			}
+
+			while (ordered)
+			{
+				std::unique_ptr<node_t> current{ordered};
+				ordered = current->next;
+				accessor(std::move(current->value));
+			}
+		}
+
+		bool empty() const
+		{
+			return head_.load(std::memory_order_acquire) == nullptr;
+		}
+
+	private:
+		struct node_t
+		{
+			T value;
+			node_t* next;
+		};
+
+		std::atomic<node_t*> head_{nullptr};
+	};
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+	// Open addressing map from strings to values. Entries are stored densely in insertion order,
+	// the slot table only holds their indices and hashes. Lookups take a string_view, so callers
+	// don't have to build temporary strings. Entries can't be erased, only the whole map is cleared.
+	template <typename T>
+	class flat_string_map final
+	{
+	public:
+		using value_type = std::pair<std::string, T>;
+		using iterator = typename std::vector<value_type>::iterator;
+		using const_iterator = typename std::vector<value_type>::const_iterator;
+
+		static uint64_t hash(const std::string_view key)
+		{
+			// FNV-1a
+			auto result = 0xCBF29CE484222325ull;
+			for (const auto c : key)
+			{
+				result ^= static_cast<uint8_t>(c);
+				result *= 0x100000001B3ull;
+			}
+
+			return result;
+		}
+
+		T* find(const std::string_view key)
+		{
+			const auto index = this->find_index(key, hash(key));
+			return index == npos ? nullptr : &this->entries_[index].second;
+		}
+
+		const T* find(const std::string_view key) const
+		{
+			const auto index = this->find_index(key, hash(key));
+			return index == npos ? nullptr : &this->entries_[index].second;
+		}
+
+		bool contains(const std::string_view key) const
+		{
+			return this->find(key) != nullptr;
+		}
+
+		T& operator[](const std::string_view key)
+		{
+			return this->try_emplace(key).first->second;
+		}
+
+		template <typename V>
+		void insert_or_assign(const std::string_view key, V&& value)
+		{
+			this->try_emplace(key).first->second = std::forward<V>(value);
+		}
+
+		std::pair<iterator, bool> try_emplace(const std::string_view key)
+		{
+			const auto key_hash = hash(key);
+			const auto index = this->find_index(key, key_hash);
+			if (index != npos)
+			{
+				return {this->entries_.begin() + index, false};
+			}
+
+			if ((this->entries_.size() + 1) * 4 > this->slots_.size() * 3)
+			{
+				this->grow();
+			}
+
+			this->entries_.emplace_back(std::string{key}, T{});
+			this->insert_slot(key_hash, static_cast<uint32_t>(this->entries_.size() - 1));
+
+			return {this->entries_.end() - 1, true};
+		}
+
+		void clear()
+		{
+			this->entries_.clear();
+			this->slots_.clear();
+		}
+
+		size_t size() const
+		{
+			return this->entries_.size();
+		}
+
+		bool empty() const
+		{
+			return this->entries_.empty();
+		}
+
+		iterator begin() { return this->entries_.begin(); }
+		iterator end() { return this->entries_.end(); }
+		const_iterator begin() const { return this->entries_.begin(); }
+		const_iterator end() const { return this->entries_.end(); }
+
+	private:
+		static constexpr auto npos = static_cast<size_t>(-1);
+
+		struct slot
+		{
+			uint64_t hash;
+			uint32_t index; // entry index + 1, 0 marks an empty slot
+		};
+
+		std::vector<value_type> entries_;
+		std::vector<slot> slots_;
+
+		size_t find_index(const std::string_view key, const uint64_t key_hash) const
+		{
+			if (this->slots_.empty())
+			{
+				return npos;
+			}
+
+			const auto mask = this->slots_.size() - 1;
+			for (auto i = key_hash & mask;; i = (i + 1) & mask)
+			{
+				const auto& entry = this->slots_[i];
+				if (!entry.index)
+				{
+					return npos;
+				}
+
+				if (entry.hash == key_hash && this->entries_[entry.index - 1].first == key)
+				{
+					return entry.index - 1;
+				}
+			}
+		}
+
+		void insert_slot(const uint64_t key_hash, const uint32_t index)
+		{
+			const auto mask = this->slots_.size() - 1;
+			auto i = key_hash & mask;
+
+			while (this->slots_[i].index)
+			{
+				i = (i + 1) & mask;
+			}
+
+			this->slots_[i] = {key_hash, index + 1};
+		}
+
+		void grow()
+		{
+			const auto slot_count = std::max(size_t(16), this->slots_.size() * 2);
+			this->slots_.assign(slot_count, {});
+
+			for (size_t i = 0; i < this->entries_.size(); ++i)
+			{
+				this->insert_slot(hash(this->entries_[i].first), static_cast<uint32_t>(i));
+			}
+		}
+	};
+}
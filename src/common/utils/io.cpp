@@ -1,9 +1,207 @@
 #include "io.hpp"
 #include "nt.hpp"
+#include "thread.hpp"
+#include <algorithm>
+#include <condition_variable>
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include <gsl/gsl>
 
 namespace utils::io
 {
+	namespace
+	{
+		constexpr size_t min_mapped_file_size = 0x10000;
+
+		bool read_handle(const HANDLE handle, std::string& buffer, const size_t size)
+		{
+			buffer.resize(size);
+
+			size_t offset = 0;
+			while (offset < size)
+			{
+				const auto chunk = static_cast<DWORD>(std::min(size - offset, size_t(0x40000000)));
+
+				DWORD read = 0;
+				if (!ReadFile(handle, buffer.data() + offset, chunk, &read, nullptr) || read == 0)
+				{
+					return false;
+				}
+
+				offset += read;
+			}
+
+			return true;
+		}
+
+		class deferred_writer final
+		{
+		public:
+			deferred_writer() = default;
+
+			~deferred_writer()
+			{
+				this->flush();
+
+				{
+					std::lock_guard _(this->mutex_);
+					this->kill_ = true;
+				}
+
+				this->cv_.notify_all();
+
+				if (this->thread_.joinable())
+				{
+					this->thread_.join();
+				}
+			}
+
+			deferred_writer(const deferred_writer&) = delete;
+			deferred_writer& operator=(const deferred_writer&) = delete;
+
+			void write(const std::string& file, std::string&& data, const std::chrono::milliseconds delay)
+			{
+				{
+					std::lock_guard _(this->mutex_);
+
+					auto& entry = this->pending_[file];
+					if (!entry.generation)
+					{
+						// Only the first write starts the timer, so a file that is
+						// constantly rewritten still reaches the disk
+						entry.deadline = std::chrono::steady_clock::now() + delay;
+					}
+
+					entry.data = std::move(data);
+					++entry.generation;
+
+					if (!this->thread_.joinable())
+					{
+						this->thread_ = thread::create_named_thread("Deferred File Writer", [this]()
+						{
+							this->work();
+						});
+					}
+				}
+
+				this->cv_.notify_all();
+			}
+
+			std::optional<std::string> find(const std::string& file)
+			{
+				std::lock_guard _(this->mutex_);
+
+				const auto entry = this->pending_.find(file);
+				if (entry == this->pending_.end())
+				{
+					return {};
+				}
+
+				return {entry->second.data};
+			}
+
+			void flush()
+			{
+				std::unique_lock lock(this->mutex_);
+				if (this->pending_.empty() || !this->thread_.joinable())
+				{
+					return;
+				}
+
+				const auto now = std::chrono::steady_clock::now();
+				for (auto& entry : this->pending_)
+				{
+					entry.second.deadline = now;
+				}
+
+				this->cv_.notify_all();
+				this->cv_.wait(lock, [this]()
+				{
+					return this->pending_.empty();
+				});
+			}
+
+		private:
+			struct pending_write
+			{
+				std::string data;
+				std::chrono::steady_clock::time_point deadline;
+				size_t generation{};
+			};
+
+			std::mutex mutex_;
+			std::condition_variable cv_;
+			std::unordered_map<std::string, pending_write> pending_;
+			std::thread thread_;
+			bool kill_{false};
+
+			void work()
+			{
+				std::unique_lock lock(this->mutex_);
+
+				while (!this->kill_)
+				{
+					if (this->pending_.empty())
+					{
+						this->cv_.wait(lock);
+						continue;
+					}
+
+					const auto now = std::chrono::steady_clock::now();
+					auto next_deadline = std::chrono::steady_clock::time_point::max();
+
+					std::vector<std::pair<std::string, pending_write>> due;
+					for (const auto& [file, entry] : this->pending_)
+					{
+						if (entry.deadline <= now)
+						{
+							due.emplace_back(file, entry);
+						}
+						else
+						{
+							next_deadline = std::min(next_deadline, entry.deadline);
+						}
+					}
+
+					if (due.empty())
+					{
+						this->cv_.wait_until(lock, next_deadline);
+						continue;
+					}
+
+					// Entries stay visible to readers until they are on disk
+					lock.unlock();
+
+					for (const auto& [file, entry] : due)
+					{
+						write_file_atomic(file, entry.data);
+					}
+
+					lock.lock();
+
+					for (const auto& [file, entry] : due)
+					{
+						const auto i = this->pending_.find(file);
+						if (i != this->pending_.end() && i->second.generation == entry.generation)
+						{
+							this->pending_.erase(i);
+						}
+					}
+
+					this->cv_.notify_all();
+				}
+			}
+		};
+
+		deferred_writer& get_deferred_writer()
+		{
+			static deferred_writer writer;
+			return writer;
+		}
+	}
+
 	bool remove_file(const std::string& file)
 	{
 		return DeleteFileA(file.data()) == TRUE;
@@ -40,6 +238,60 @@ namespace utils::io
 		return false;
 	}
 
+	bool write_file_atomic(const std::string& file, const std::string& data)
+	{
+		const auto pos = file.find_last_of("/\\");
+		if (pos != std::string::npos)
+		{
+			const auto directory = file.substr(0, pos);
+			if (!directory_exists(directory))
+			{
+				create_directory(directory);
+			}
+		}
+
+		const auto temp_file = file + "." + std::to_string(GetCurrentThreadId()) + ".tmp";
+
+		{
+			std::ofstream stream(temp_file, std::ios::binary | std::ofstream::out | std::ofstream::trunc);
+			if (!stream.is_open())
+			{
+				return false;
+			}
+
+			stream.write(data.data(), data.size());
+			if (!stream.good())
+			{
+				stream.close();
+				remove_file(temp_file);
+				return false;
+			}
+		}
+
+		if (!MoveFileExA(temp_file.data(), file.data(), MOVEFILE_REPLACE_EXISTING))
+		{
+			remove_file(temp_file);
+			return false;
+		}
+
+		return true;
+	}
+
+	void write_file_deferred(const std::string& file, std::string data, const std::chrono::milliseconds delay)
+	{
+		get_deferred_writer().write(file, std::move(data), delay);
+	}
+
+	std::optional<std::string> get_deferred_write(const std::string& file)
+	{
+		return get_deferred_writer().find(file);
+	}
+
+	void flush_deferred_writes()
+	{
+		get_deferred_writer().flush();
+	}
+
 	std::string read_file(const std::string& file)
 	{
 		std::string data;
@@ -52,22 +304,19 @@ namespace utils::io
 		if (!data) return false;
 		data->clear();
 
-		if (file_exists(file))
-		{
-			std::ifstream stream(file, std::ios::binary);
-			if (!stream.is_open()) return false;
+		std::ifstream stream(file, std::ios::binary);
+		if (!stream.is_open()) return false;
 
-			stream.seekg(0, std::ios::end);
-			const std::streamsize size = stream.tellg();
-			stream.seekg(0, std::ios::beg);
+		stream.seekg(0, std::ios::end);
+		const std::streamsize size = stream.tellg();
+		stream.seekg(0, std::ios::beg);
 
-			if (size > -1)
-			{
-				data->resize(static_cast<uint32_t>(size));
-				stream.read(const_cast<char*>(data->data()), size);
-				stream.close();
-				return true;
-			}
+		if (size > -1)
+		{
+			data->resize(static_cast<size_t>(size));
+			stream.read(data->data(), size);
+			stream.close();
+			return true;
 		}
 
 		return false;
@@ -139,4 +388,235 @@ namespace utils::io
 		                      std::filesystem::copy_options::overwrite_existing |
 		                      std::filesystem::copy_options::recursive);
 	}
+
+	mapped_file::mapped_file(const std::string& file)
+	{
+		// Other processes may still replace or rewrite the file, Windows refuses to truncate it while mapped
+		const auto handle = CreateFileA(file.data(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		                                nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		const auto _ = gsl::finally([handle]()
+		{
+			CloseHandle(handle);
+		});
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(handle, &size))
+		{
+			return;
+		}
+
+		const auto file_size = static_cast<size_t>(size.QuadPart);
+
+		if (file_size < min_mapped_file_size)
+		{
+			this->valid_ = read_handle(handle, this->buffer_, file_size);
+		}
+		else
+		{
+			// The view keeps the mapping and the file alive, both handles can be closed right away
+			const auto mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping)
+			{
+				return;
+			}
+
+			this->view_ = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle(mapping);
+
+			this->valid_ = this->view_ != nullptr;
+		}
+
+		if (this->valid_)
+		{
+			this->size_ = file_size;
+		}
+	}
+
+	mapped_file::~mapped_file()
+	{
+		this->release();
+	}
+
+	mapped_file::mapped_file(mapped_file&& other) noexcept
+	{
+		this->operator=(std::move(other));
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file&& other) noexcept
+	{
+		if (this != &other)
+		{
+			this->release();
+
+			this->valid_ = other.valid_;
+			this->view_ = other.view_;
+			this->size_ = other.size_;
+			this->buffer_ = std::move(other.buffer_);
+
+			other.valid_ = false;
+			other.view_ = nullptr;
+			other.size_ = 0;
+		}
+
+		return *this;
+	}
+
+	void mapped_file::release()
+	{
+		if (this->view_)
+		{
+			UnmapViewOfFile(this->view_);
+			this->view_ = nullptr;
+		}
+
+		this->buffer_.clear();
+		this->size_ = 0;
+		this->valid_ = false;
+	}
+
+	bool mapped_file::is_valid() const
+	{
+		return this->valid_;
+	}
+
+	const std::uint8_t* mapped_file::data() const
+	{
+		if (this->view_)
+		{
+			return static_cast<const std::uint8_t*>(this->view_);
+		}
+
+		return reinterpret_cast<const std::uint8_t*>(this->buffer_.data());
+	}
+
+	size_t mapped_file::size() const
+	{
+		return this->size_;
+	}
+
+	std::span<const std::uint8_t> mapped_file::get_span() const
+	{
+		return {this->data(), this->size_};
+	}
+
+	std::string_view mapped_file::get_view() const
+	{
+		return {reinterpret_cast<const char*>(this->data()), this->size_};
+	}
+
+	positioned_file::positioned_file(const std::string& file)
+	{
+		// Same sharing as the streams this replaced, tools can still rewrite or replace open mod files
+		const auto handle = CreateFileA(file.data(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		                                nullptr, OPEN_EXISTING,
+		                                FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(handle, &size))
+		{
+			CloseHandle(handle);
+			return;
+		}
+
+		this->handle_ = handle;
+		this->size_ = static_cast<std::uint64_t>(size.QuadPart);
+	}
+
+	positioned_file::~positioned_file()
+	{
+		this->close();
+	}
+
+	positioned_file::positioned_file(positioned_file&& other) noexcept
+	{
+		this->operator=(std::move(other));
+	}
+
+	positioned_file& positioned_file::operator=(positioned_file&& other) noexcept
+	{
+		if (this != &other)
+		{
+			this->close();
+
+			this->handle_ = other.handle_;
+			this->size_ = other.size_;
+
+			other.handle_ = nullptr;
+			other.size_ = 0;
+		}
+
+		return *this;
+	}
+
+	bool positioned_file::is_open() const
+	{
+		return this->handle_ != nullptr;
+	}
+
+	void positioned_file::close()
+	{
+		if (this->handle_)
+		{
+			CloseHandle(this->handle_);
+			this->handle_ = nullptr;
+		}
+	}
+
+	std::uint64_t positioned_file::size() const
+	{
+		return this->size_;
+	}
+
+	std::optional<size_t> positioned_file::read(const std::uint64_t offset, void* dest, const size_t length) const
+	{
+		if (!this->handle_)
+		{
+			return {};
+		}
+
+		if (offset >= this->size_)
+		{
+			return {0};
+		}
+
+		const auto to_read = static_cast<size_t>(std::min(static_cast<std::uint64_t>(length), this->size_ - offset));
+		auto* buffer = static_cast<std::uint8_t*>(dest);
+
+		size_t total = 0;
+		while (total < to_read)
+		{
+			const auto position = offset + total;
+
+			// Passing the offset through OVERLAPPED makes this a pread, no seek is needed
+			OVERLAPPED overlapped{};
+			overlapped.Offset = static_cast<DWORD>(position);
+			overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+			const auto chunk = static_cast<DWORD>(std::min(to_read - total, size_t(0x40000000)));
+
+			DWORD read = 0;
+			if (!ReadFile(this->handle_, buffer + total, chunk, &read, &overlapped))
+			{
+				return {};
+			}
+
+			if (read == 0)
+			{
+				break;
+			}
+
+			total += read;
+		}
+
+		return {total};
+	}
 }
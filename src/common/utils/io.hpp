@@ -1,6 +1,10 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <filesystem>
 
@@ -10,6 +14,18 @@ namespace utils::io
 	bool move_file(const std::string& src, const std::string& target);
 	bool file_exists(const std::string& file);
 	bool write_file(const std::string& file, const std::string& data, bool append = false);
+
+	// Writes to a temporary file and renames it over the target,
+	// a crash during the write never leaves a torn file behind
+	bool write_file_atomic(const std::string& file, const std::string& data);
+
+	// Queues an atomic write on a background thread, repeated writes to the
+	// same file within the delay are collapsed into a single disk write
+	void write_file_deferred(const std::string& file, std::string data,
+	                         std::chrono::milliseconds delay = std::chrono::milliseconds(500));
+	std::optional<std::string> get_deferred_write(const std::string& file);
+	void flush_deferred_writes();
+
 	bool read_file(const std::string& file, std::string* data);
 	std::string read_file(const std::string& file);
 	size_t file_size(const std::string& file);
@@ -20,4 +36,63 @@ namespace utils::io
 	std::vector<std::string> list_files(const std::string& directory);
 	std::vector<std::string> list_files_recursively(const std::string& directory);
 	void copy_folder(const std::filesystem::path& src, const std::filesystem::path& target);
+
+	// Read-only view of a whole file. Files are memory mapped, tiny files
+	// are read into a buffer instead since mapping them costs more than a copy.
+	class mapped_file final
+	{
+	public:
+		mapped_file() = default;
+		explicit mapped_file(const std::string& file);
+		~mapped_file();
+
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		bool is_valid() const;
+
+		const std::uint8_t* data() const;
+		size_t size() const;
+
+		std::span<const std::uint8_t> get_span() const;
+		std::string_view get_view() const;
+
+	private:
+		bool valid_{false};
+		void* view_{nullptr};
+		size_t size_{0};
+		std::string buffer_{};
+
+		void release();
+	};
+
+	// Handle for random access reads at explicit offsets, the file size is queried once when opening
+	class positioned_file final
+	{
+	public:
+		positioned_file() = default;
+		explicit positioned_file(const std::string& file);
+		~positioned_file();
+
+		positioned_file(positioned_file&& other) noexcept;
+		positioned_file& operator=(positioned_file&& other) noexcept;
+
+		positioned_file(const positioned_file&) = delete;
+		positioned_file& operator=(const positioned_file&) = delete;
+
+		bool is_open() const;
+		void close();
+
+		std::uint64_t size() const;
+
+		// Reads up to length bytes at the given offset, returns the amount of bytes read or nothing on error
+		std::optional<size_t> read(std::uint64_t offset, void* dest, size_t length) const;
+
+	private:
+		void* handle_{nullptr};
+		std::uint64_t size_{0};
+	};
 }
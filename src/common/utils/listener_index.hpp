@@ -0,0 +1,277 @@
+#pragma once
+
+#include "flat_map.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace utils
+{
+	// Listeners bucketed by event name and entity id. Removed listeners are only flagged and stay in
+	// their bucket until it gets compacted, so a bucket can be iterated while its listeners are removed.
+	// Listener has to provide id, event, entity.get_entity_id(), is_deleted and endon_conditions,
+	// a list of (entity, event name) pairs that remove the listener when notified.
+	template <typename Listener>
+	class listener_index final
+	{
+	public:
+		using listener_list = std::vector<Listener>;
+
+		void add(Listener&& listener)
+		{
+			if (listener.is_deleted)
+			{
+				return;
+			}
+
+			for (const auto& [entity, event] : listener.endon_conditions)
+			{
+				this->endon_conditions_[entity.get_entity_id()][event].emplace_back(listener.id);
+			}
+
+			const auto key = this->get_key(listener.event, listener.entity.get_entity_id());
+			++this->listener_counts_[get_name_index(key)];
+			this->listener_keys_[listener.id] = key;
+			this->buckets_[key].emplace_back(std::move(listener));
+		}
+
+		Listener* find(const uint64_t id)
+		{
+			const auto key = this->listener_keys_.find(id);
+			if (key == this->listener_keys_.end())
+			{
+				return nullptr;
+			}
+
+			const auto bucket = this->buckets_.find(key->second);
+			if (bucket == this->buckets_.end())
+			{
+				return nullptr;
+			}
+
+			for (auto& listener : bucket->second)
+			{
+				if (listener.id == id)
+				{
+					return &listener;
+				}
+			}
+
+			return nullptr;
+		}
+
+		void remove(const uint64_t id)
+		{
+			auto* listener = this->find(id);
+			if (listener && !listener->is_deleted)
+			{
+				listener->is_deleted = true;
+				this->dirty_buckets_.insert(this->listener_keys_[id]);
+			}
+		}
+
+		template <typename Entity>
+		void add_endon_condition(const uint64_t id, const Entity& entity, const std::string& event)
+		{
+			auto* listener = this->find(id);
+			if (listener)
+			{
+				listener->endon_conditions.emplace_back(entity, event);
+				this->endon_conditions_[entity.get_entity_id()][event].emplace_back(id);
+			}
+		}
+
+		// Removes every listener that ends on the event
+		void handle_endon_conditions(const unsigned int entity_id, const std::string& event)
+		{
+			const auto entity_conditions = this->endon_conditions_.find(entity_id);
+			if (entity_conditions == this->endon_conditions_.end())
+			{
+				return;
+			}
+
+			const auto conditions = entity_conditions->second.find(event);
+			if (conditions == entity_conditions->second.end())
+			{
+				return;
+			}
+
+			for (const auto id : conditions->second)
+			{
+				this->remove(id);
+			}
+		}
+
+		// Calls the callback for every listener of the event that was added before the call.
+		// The callback can flag the listener as deleted, e.g. before running code that dispatches again
+		template <typename F>
+		void dispatch(const std::string_view event, const unsigned int entity_id, F&& callback)
+		{
+			const auto key = this->find_key(event, entity_id);
+			if (!key.has_value())
+			{
+				return;
+			}
+
+			const auto bucket = this->buckets_.find(key.value());
+			if (bucket == this->buckets_.end())
+			{
+				return;
+			}
+
+			// Callbacks can add new listeners to this bucket, only index it
+			auto& listeners = bucket->second;
+			const auto count = listeners.size();
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (listeners[i].is_deleted)
+				{
+					continue;
+				}
+
+				callback(listeners[i]);
+
+				if (listeners[i].is_deleted)
+				{
+					this->dirty_buckets_.insert(key.value());
+				}
+			}
+		}
+
+		bool has_listeners(const std::string_view event) const
+		{
+			const auto* name = this->event_names_.find(event);
+			return name && this->listener_counts_[*name] > 0;
+		}
+
+		// Drops removed listeners from at most max_buckets buckets
+		void compact(const size_t max_buckets)
+		{
+			size_t compacted = 0;
+
+			for (auto i = this->dirty_buckets_.begin(); i != this->dirty_buckets_.end()
+				&& compacted < max_buckets; ++compacted)
+			{
+				const auto bucket = this->buckets_.find(*i);
+				i = this->dirty_buckets_.erase(i);
+
+				if (bucket == this->buckets_.end())
+				{
+					continue;
+				}
+
+				auto& listeners = bucket->second;
+				std::erase_if(listeners, [&](const Listener& listener)
+				{
+					if (listener.is_deleted)
+					{
+						--this->listener_counts_[get_name_index(bucket->first)];
+						this->listener_keys_.erase(listener.id);
+						this->remove_endon_conditions(listener);
+						return true;
+					}
+
+					return false;
+				});
+
+				if (listeners.empty())
+				{
+					this->buckets_.erase(bucket);
+				}
+			}
+		}
+
+		void clear()
+		{
+			this->event_names_.clear();
+			this->listener_counts_.clear();
+			this->buckets_.clear();
+			this->listener_keys_.clear();
+			this->dirty_buckets_.clear();
+			this->endon_conditions_.clear();
+		}
+
+		size_t bucket_count() const
+		{
+			return this->buckets_.size();
+		}
+
+	private:
+		// Entity id in the low bits, interned event name in the high bits
+		using listener_key = uint64_t;
+
+		// Entity id -> event name -> ids of listeners that end on it
+		using endon_index = std::unordered_map<unsigned int, std::unordered_map<std::string, std::vector<uint64_t>>>;
+
+		flat_string_map<uint32_t> event_names_;
+		std::vector<size_t> listener_counts_; // Per event name, includes removed listeners until compaction
+		std::unordered_map<listener_key, listener_list> buckets_;
+		std::unordered_map<uint64_t, listener_key> listener_keys_;
+		std::unordered_set<listener_key> dirty_buckets_;
+		endon_index endon_conditions_;
+
+		static uint32_t get_name_index(const listener_key key)
+		{
+			return static_cast<uint32_t>(key >> 32);
+		}
+
+		std::optional<listener_key> find_key(const std::string_view event, const unsigned int entity_id) const
+		{
+			const auto* name = this->event_names_.find(event);
+			if (!name)
+			{
+				return {};
+			}
+
+			return {(static_cast<uint64_t>(*name) << 32) | entity_id};
+		}
+
+		listener_key get_key(const std::string_view event, const unsigned int entity_id)
+		{
+			const auto [name, inserted] = this->event_names_.try_emplace(event);
+			if (inserted)
+			{
+				name->second = static_cast<uint32_t>(this->listener_counts_.size());
+				this->listener_counts_.push_back(0);
+			}
+
+			return (static_cast<uint64_t>(name->second) << 32) | entity_id;
+		}
+
+		void remove_endon_conditions(const Listener& listener)
+		{
+			for (const auto& [entity, event] : listener.endon_conditions)
+			{
+				const auto entity_conditions = this->endon_conditions_.find(entity.get_entity_id());
+				if (entity_conditions == this->endon_conditions_.end())
+				{
+					continue;
+				}
+
+				const auto conditions = entity_conditions->second.find(event);
+				if (conditions == entity_conditions->second.end())
+				{
+					continue;
+				}
+
+				std::erase(conditions->second, listener.id);
+
+				if (conditions->second.empty())
+				{
+					entity_conditions->second.erase(conditions);
+				}
+
+				if (entity_conditions->second.empty())
+				{
+					this->endon_conditions_.erase(entity_conditions);
+				}
+			}
+		}
+	};
+}
@@ -1,11 +1,241 @@
 #include "signature.hpp"
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 
 #include <intrin.h>
 
 namespace utils::hook
 {
+	namespace
+	{
+		// Small enough for a chunk to stay in L2 while every pattern of a batch runs over it
+		constexpr size_t scan_chunk_size = 0x40000;
+
+		// Worker threads stay alive between scans, so resolving many
+		// signatures does not pay for spawning threads every time
+		class scan_pool final
+		{
+		public:
+			using job_t = std::function<void(size_t)>;
+
+			scan_pool()
+			{
+				// Only use half of the available cores, the calling thread counts as one of them
+				const auto cores = std::max(1u, std::thread::hardware_concurrency() / 2);
+				for (auto i = 1u; i < cores; ++i)
+				{
+					this->threads_.emplace_back([this]()
+					{
+						this->work();
+					});
+				}
+			}
+
+			~scan_pool()
+			{
+				{
+					std::lock_guard _(this->mutex_);
+					this->kill_ = true;
+				}
+
+				this->work_cv_.notify_all();
+
+				for (auto& t : this->threads_)
+				{
+					if (t.joinable())
+					{
+						t.join();
+					}
+				}
+			}
+
+			scan_pool(const scan_pool&) = delete;
+			scan_pool& operator=(const scan_pool&) = delete;
+
+			void run(const size_t count, const job_t& job)
+			{
+				std::lock_guard run_lock(this->run_mutex_);
+
+				{
+					std::lock_guard _(this->mutex_);
+					this->job_ = &job;
+					this->count_ = count;
+					this->next_ = 0;
+					this->active_ = this->threads_.size();
+					++this->generation_;
+				}
+
+				this->work_cv_.notify_all();
+				this->execute(job, count);
+
+				std::unique_lock lock(this->mutex_);
+				this->done_cv_.wait(lock, [this]()
+				{
+					return this->active_ == 0;
+				});
+
+				this->job_ = nullptr;
+			}
+
+		private:
+			std::mutex run_mutex_;
+			std::mutex mutex_;
+			std::condition_variable work_cv_;
+			std::condition_variable done_cv_;
+
+			const job_t* job_ = nullptr;
+			size_t count_ = 0;
+			size_t active_ = 0;
+			size_t generation_ = 0;
+			bool kill_ = false;
+
+			std::atomic<size_t> next_ = 0;
+			std::vector<std::thread> threads_;
+
+			void execute(const job_t& job, const size_t count)
+			{
+				for (auto i = this->next_++; i < count; i = this->next_++)
+				{
+					job(i);
+				}
+			}
+
+			void work()
+			{
+				size_t generation = 0;
+
+				while (true)
+				{
+					const job_t* job{};
+					size_t count{};
+
+					{
+						std::unique_lock lock(this->mutex_);
+						this->work_cv_.wait(lock, [&]()
+						{
+							return this->kill_ || this->generation_ != generation;
+						});
+
+						if (this->kill_)
+						{
+							return;
+						}
+
+						generation = this->generation_;
+						job = this->job_;
+						count = this->count_;
+					}
+
+					this->execute(*job, count);
+
+					{
+						std::lock_guard _(this->mutex_);
+						--this->active_;
+					}
+
+					this->done_cv_.notify_one();
+				}
+			}
+		};
+
+		struct cpu_features
+		{
+			bool sse42{};
+			bool avx2{};
+			bool avx512{};
+		};
+
+		cpu_features detect_cpu_features()
+		{
+			cpu_features features{};
+
+			int cpu_id[4];
+			__cpuid(cpu_id, 0);
+
+			const auto max_leaf = cpu_id[0];
+			if (max_leaf < 1)
+			{
+				return features;
+			}
+
+			__cpuidex(cpu_id, 1, 0);
+			features.sse42 = (cpu_id[2] & (1 << 20)) != 0;
+
+			const auto os_xsave = (cpu_id[2] & (1 << 27)) != 0;
+			const auto avx = (cpu_id[2] & (1 << 28)) != 0;
+			if (!os_xsave || !avx || max_leaf < 7)
+			{
+				return features;
+			}
+
+			// The OS has to preserve the ymm/zmm registers across context switches
+			const auto xcr0 = _xgetbv(0);
+			const auto ymm_state = (xcr0 & 0x6) == 0x6;
+			const auto zmm_state = (xcr0 & 0xE6) == 0xE6;
+
+			__cpuidex(cpu_id, 7, 0);
+			features.avx2 = ymm_state && (cpu_id[1] & (1 << 5)) != 0;
+			features.avx512 = zmm_state && (cpu_id[1] & (1 << 16)) != 0 && (cpu_id[1] & (1 << 30)) != 0;
+
+			return features;
+		}
+
+		const cpu_features& get_cpu_features()
+		{
+			static const auto features = detect_cpu_features();
+			return features;
+		}
+
+		size_t get_byte_frequency(const uint8_t byte)
+		{
+			// Rough ranking of the most frequent bytes in x64 code, most frequent first
+			static constexpr uint8_t common_bytes[] =
+			{
+				0x00, 0xFF, 0x48, 0x8B, 0xCC, 0x89, 0x24, 0x4C, 0x0F, 0xE8, 0x8D, 0x44,
+				0x85, 0xC0, 0x83, 0x01, 0x4D, 0x49, 0x41, 0x74, 0x75, 0xC3, 0x90, 0x40,
+				0x20, 0x08, 0x10, 0x30, 0x28, 0x38, 0x5C, 0xC7, 0x33, 0x84, 0x45, 0xEB,
+			};
+
+			for (size_t i = 0; i < std::size(common_bytes); ++i)
+			{
+				if (common_bytes[i] == byte)
+				{
+					return std::size(common_bytes) - i;
+				}
+			}
+
+			return 0;
+		}
+
+		scan_pool& get_scan_pool()
+		{
+			static scan_pool pool;
+			return pool;
+		}
+
+		std::vector<size_t> join_chunk_results(std::vector<std::vector<size_t>>& chunks)
+		{
+			size_t total = 0;
+			for (const auto& chunk : chunks)
+			{
+				total += chunk.size();
+			}
+
+			std::vector<size_t> result;
+			result.reserve(total);
+
+			// Chunks are ordered by address, so the joined result is already sorted
+			for (auto& chunk : chunks)
+			{
+				result.insert(result.end(), chunk.begin(), chunk.end());
+			}
+
+			return result;
+		}
+	}
+
 	void signature::load_pattern(const std::string& pattern)
 	{
 		this->mask_.clear();
@@ -54,24 +284,107 @@ namespace utils::hook
 			this->pattern_.pop_back();
 		}
 
-		if (this->has_sse_support())
+		if (has_nibble)
+		{
+			throw std::runtime_error("Invalid pattern");
+		}
+
+		this->select_kernel();
+		this->select_anchors();
+
+		if (this->kernel_ == scan_kernel::sse42)
 		{
 			while (this->pattern_.size() < 16)
 			{
 				this->pattern_.push_back(0);
 			}
 		}
+	}
 
-		if (has_nibble)
+	void signature::select_kernel()
+	{
+		const auto& features = get_cpu_features();
+
+		if (this->mask_.empty())
 		{
-			throw std::runtime_error("Invalid pattern");
+			this->kernel_ = scan_kernel::linear;
+		}
+		else if (features.avx512)
+		{
+			this->kernel_ = scan_kernel::avx512;
+		}
+		else if (features.avx2)
+		{
+			this->kernel_ = scan_kernel::avx2;
+		}
+		else if (features.sse42 && this->mask_.size() <= 16)
+		{
+			this->kernel_ = scan_kernel::sse42;
+		}
+		else
+		{
+			this->kernel_ = scan_kernel::linear;
 		}
 	}
 
+	void signature::select_anchors()
+	{
+		// The two rarest fixed bytes are compared across a whole vector at once,
+		// the full mask is only checked where both of them match
+		std::vector<size_t> candidates;
+		for (size_t i = 0; i < this->mask_.size(); ++i)
+		{
+			if (this->mask_[i] != '?')
+			{
+				candidates.push_back(i);
+			}
+		}
+
+		if (candidates.empty())
+		{
+			return;
+		}
+
+		std::stable_sort(candidates.begin(), candidates.end(), [this](const size_t a, const size_t b)
+		{
+			return get_byte_frequency(this->pattern_[a]) < get_byte_frequency(this->pattern_[b]);
+		});
+
+		const auto first = candidates[0];
+		const auto second = candidates.size() > 1 ? candidates[1] : first;
+
+		this->anchor_offsets_[0] = first;
+		this->anchor_offsets_[1] = second;
+		this->anchor_bytes_[0] = this->pattern_[first];
+		this->anchor_bytes_[1] = this->pattern_[second];
+	}
+
+	bool signature::matches(const uint8_t* address) const
+	{
+		for (size_t j = 0; j < this->mask_.size(); ++j)
+		{
+			if (this->mask_[j] != '?' && this->pattern_[j] != address[j])
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	std::vector<size_t> signature::process_range(uint8_t* start, const size_t length) const
 	{
-		if (this->has_sse_support()) return this->process_range_vectorized(start, length);
-		return this->process_range_linear(start, length);
+		switch (this->kernel_)
+		{
+		case scan_kernel::avx512:
+			return this->process_range_avx512(start, length);
+		case scan_kernel::avx2:
+			return this->process_range_avx2(start, length);
+		case scan_kernel::sse42:
+			return this->process_range_vectorized(start, length);
+		default:
+			return this->process_range_linear(start, length);
+		}
 	}
 
 	std::vector<size_t> signature::process_range_linear(uint8_t* start, const size_t length) const
@@ -81,17 +394,7 @@ namespace utils::hook
 		for (size_t i = 0; i < length; ++i)
 		{
 			const auto address = start + i;
-
-			size_t j = 0;
-			for (; j < this->mask_.size(); ++j)
-			{
-				if (this->mask_[j] != '?' && this->pattern_[j] != address[j])
-				{
-					break;
-				}
-			}
-
-			if (j == this->mask_.size())
+			if (this->matches(address))
 			{
 				result.push_back(size_t(address));
 			}
@@ -132,6 +435,93 @@ namespace utils::hook
 		return result;
 	}
 
+	std::vector<size_t> signature::process_range_avx2(uint8_t* start, const size_t length) const
+	{
+		std::vector<size_t> result;
+
+		const auto first_anchor = _mm256_set1_epi8(static_cast<char>(this->anchor_bytes_[0]));
+		const auto second_anchor = _mm256_set1_epi8(static_cast<char>(this->anchor_bytes_[1]));
+
+		size_t i = 0;
+		for (; i + 32 <= length; i += 32)
+		{
+			const auto first = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(start + i + this->anchor_offsets_[0]));
+			const auto second = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(start + i + this->anchor_offsets_[1]));
+
+			const auto comparison = _mm256_and_si256(_mm256_cmpeq_epi8(first, first_anchor),
+			                                         _mm256_cmpeq_epi8(second, second_anchor));
+			unsigned long candidates = static_cast<uint32_t>(_mm256_movemask_epi8(comparison));
+
+			while (candidates)
+			{
+				unsigned long bit{};
+				_BitScanForward(&bit, candidates);
+				candidates &= candidates - 1;
+
+				const auto address = start + i + bit;
+				if (this->matches(address))
+				{
+					result.push_back(size_t(address));
+				}
+			}
+		}
+
+		for (; i < length; ++i)
+		{
+			const auto address = start + i;
+			if (this->matches(address))
+			{
+				result.push_back(size_t(address));
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<size_t> signature::process_range_avx512(uint8_t* start, const size_t length) const
+	{
+		std::vector<size_t> result;
+
+		const auto first_anchor = _mm512_set1_epi8(static_cast<char>(this->anchor_bytes_[0]));
+		const auto second_anchor = _mm512_set1_epi8(static_cast<char>(this->anchor_bytes_[1]));
+
+		size_t i = 0;
+		for (; i + 64 <= length; i += 64)
+		{
+			const auto first = _mm512_loadu_si512(start + i + this->anchor_offsets_[0]);
+			const auto second = _mm512_loadu_si512(start + i + this->anchor_offsets_[1]);
+
+			auto candidates = static_cast<unsigned long long>(_mm512_cmpeq_epi8_mask(first, first_anchor) &
+				_mm512_cmpeq_epi8_mask(second, second_anchor));
+
+			while (candidates)
+			{
+				unsigned long bit{};
+				_BitScanForward64(&bit, candidates);
+				candidates &= candidates - 1;
+
+				const auto address = start + i + bit;
+				if (this->matches(address))
+				{
+					result.push_back(size_t(address));
+				}
+			}
+		}
+
+		for (; i < length; ++i)
+		{
+			const auto address = start + i;
+			if (this->matches(address))
+			{
+				result.push_back(size_t(address));
+			}
+		}
+
+		return result;
+	}
+
 	signature::signature_result signature::process() const
 	{
 		const auto range = this->length_ - this->mask_.size();
@@ -143,66 +533,88 @@ namespace utils::hook
 
 	signature::signature_result signature::process_serial() const
 	{
-		const auto sub = this->has_sse_support() ? 16 : this->mask_.size();
-		return {this->process_range(this->start_, this->length_ - sub)};
+		return {this->process_range(this->start_, this->length_ - this->get_scan_padding())};
 	}
 
 	signature::signature_result signature::process_parallel() const
 	{
-		const auto sub = this->has_sse_support() ? 16 : this->mask_.size();
-		const auto range = this->length_ - sub;
-		const auto cores = std::max(1u, std::thread::hardware_concurrency() / 2);
-		// Only use half of the available cores
-		const auto grid = range / cores;
+		const auto range = this->length_ - this->get_scan_padding();
+		const auto chunk_count = (range + scan_chunk_size - 1) / scan_chunk_size;
 
-		std::mutex mutex;
-		std::vector<size_t> result;
-		std::vector<std::thread> threads;
+		std::vector<std::vector<size_t>> chunks(chunk_count);
 
-		for (auto i = 0u; i < cores; ++i)
+		get_scan_pool().run(chunk_count, [&](const size_t chunk)
 		{
-			const auto start = this->start_ + (grid * i);
-			const auto length = (i + 1 == cores) ? (this->start_ + this->length_ - sub) - start : grid;
-			threads.emplace_back([&, start, length]()
-			{
-				auto local_result = this->process_range(start, length);
-				if (local_result.empty()) return;
+			const auto offset = chunk * scan_chunk_size;
+			const auto length = std::min(scan_chunk_size, range - offset);
+			chunks[chunk] = this->process_range(this->start_ + offset, length);
+		});
 
-				std::lock_guard _(mutex);
-				for (const auto& address : local_result)
-				{
-					result.push_back(address);
-				}
-			});
-		}
+		return {join_chunk_results(chunks)};
+	}
 
-		for (auto& t : threads)
-		{
-			if (t.joinable())
-			{
-				t.join();
-			}
-		}
+	size_t signature::get_scan_padding() const
+	{
+		// The SSE kernel always reads a full 16 byte vector at each offset
+		return this->kernel_ == scan_kernel::sse42 ? 16 : this->mask_.size();
+	}
 
-		std::sort(result.begin(), result.end());
-		return {std::move(result)};
+	size_t signature_batch::add(const std::string& pattern)
+	{
+		this->signatures_.emplace_back(pattern, this->start_, this->length_);
+		return this->signatures_.size() - 1;
+	}
+
+	size_t signature_batch::size() const
+	{
+		return this->signatures_.size();
 	}
 
-	bool signature::has_sse_support() const
+	std::vector<signature::signature_result> signature_batch::process() const
 	{
-		if (this->mask_.size() <= 16)
+		const auto chunk_count = (this->length_ + scan_chunk_size - 1) / scan_chunk_size;
+		const auto signature_count = this->signatures_.size();
+
+		// Indexed [signature][chunk], every chunk is written by exactly one job
+		std::vector<std::vector<std::vector<size_t>>> chunks(signature_count);
+		for (auto& signature_chunks : chunks)
 		{
-			int cpu_id[4];
-			__cpuid(cpu_id, 0);
+			signature_chunks.resize(chunk_count);
+		}
+
+		get_scan_pool().run(chunk_count, [&](const size_t chunk)
+		{
+			const auto offset = chunk * scan_chunk_size;
+			const auto chunk_end = std::min(offset + scan_chunk_size, this->length_);
 
-			if (cpu_id[0] >= 1)
+			for (size_t i = 0; i < signature_count; ++i)
 			{
-				__cpuidex(cpu_id, 1, 0);
-				return (cpu_id[2] & (1 << 20)) != 0;
+				const auto& sig = this->signatures_[i];
+				const auto padding = sig.get_scan_padding();
+				if (padding >= this->length_)
+				{
+					continue;
+				}
+
+				const auto end = std::min(chunk_end, this->length_ - padding);
+				if (offset >= end)
+				{
+					continue;
+				}
+
+				chunks[i][chunk] = sig.process_range(this->start_ + offset, end - offset);
 			}
+		});
+
+		std::vector<signature::signature_result> result;
+		result.reserve(signature_count);
+
+		for (auto& signature_chunks : chunks)
+		{
+			result.emplace_back(join_chunk_results(signature_chunks));
 		}
 
-		return false;
+		return result;
 	}
 }
 
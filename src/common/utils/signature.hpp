@@ -4,6 +4,8 @@
 
 namespace utils::hook
 {
+	class signature_batch;
+
 	class signature final
 	{
 	public:
@@ -52,21 +54,74 @@ namespace utils::hook
 		signature_result process() const;
 
 	private:
+		friend class signature_batch;
+
+		enum class scan_kernel
+		{
+			linear,
+			sse42,
+			avx2,
+			avx512,
+		};
+
 		std::string mask_;
 		std::basic_string<uint8_t> pattern_;
 
+		scan_kernel kernel_ = scan_kernel::linear;
+		size_t anchor_offsets_[2]{};
+		uint8_t anchor_bytes_[2]{};
+
 		uint8_t* start_;
 		size_t length_;
 
 		void load_pattern(const std::string& pattern);
+		void select_kernel();
+		void select_anchors();
+
+		bool matches(const uint8_t* address) const;
 
 		signature_result process_parallel() const;
 		signature_result process_serial() const;
 		std::vector<size_t> process_range(uint8_t* start, size_t length) const;
 		std::vector<size_t> process_range_linear(uint8_t* start, size_t length) const;
 		std::vector<size_t> process_range_vectorized(uint8_t* start, size_t length) const;
+		std::vector<size_t> process_range_avx2(uint8_t* start, size_t length) const;
+		std::vector<size_t> process_range_avx512(uint8_t* start, size_t length) const;
+
+		size_t get_scan_padding() const;
+	};
+
+	// Resolves many patterns against the same range in a single pass.
+	// The range is split into cache-sized chunks and every pattern is matched
+	// against a chunk before moving on, so the image is only read once.
+	class signature_batch final
+	{
+	public:
+		explicit signature_batch(const nt::library library = {})
+			: signature_batch(library.get_ptr(), library.get_optional_header()->SizeOfImage)
+		{
+		}
+
+		signature_batch(void* start, void* end)
+			: signature_batch(start, size_t(end) - size_t(start))
+		{
+		}
+
+		signature_batch(void* start, const size_t length)
+			: start_(static_cast<uint8_t*>(start)), length_(length)
+		{
+		}
+
+		size_t add(const std::string& pattern);
+		size_t size() const;
+
+		std::vector<signature::signature_result> process() const;
+
+	private:
+		uint8_t* start_;
+		size_t length_;
 
-		bool has_sse_support() const;
+		std::vector<signature> signatures_;
 	};
 }
 
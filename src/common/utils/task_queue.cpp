@@ -0,0 +1,170 @@
+#include "task_queue.hpp"
+
+#include <gsl/gsl>
+
+#include <algorithm>
+
+namespace utils::concurrency
+{
+	bool task_queue::task_deadline_compare::operator()(const task& a, const task& b) const
+	{
+		const auto a_deadline = a.get_deadline();
+		const auto b_deadline = b.get_deadline();
+
+		if (a_deadline != b_deadline)
+		{
+			return a_deadline > b_deadline;
+		}
+
+		return a.sequence > b.sequence;
+	}
+
+	void task_queue::add(task_handler handler, const std::chrono::milliseconds interval,
+	                     const clock::time_point last_call)
+	{
+		task task;
+		task.handler = std::move(handler);
+		task.interval = interval;
+		task.last_call = last_call;
+
+		this->new_tasks_.push(std::move(task));
+	}
+
+	void task_queue::execute(const clock::time_point now)
+	{
+		if (this->executing_)
+		{
+			return;
+		}
+
+		this->executing_ = true;
+		const auto _ = gsl::finally([this]()
+		{
+			this->executing_ = false;
+		});
+
+		this->merge_tasks();
+		this->execute_tasks(now);
+	}
+
+	task_queue::clock::time_point task_queue::get_next_deadline(const clock::time_point now,
+	                                                            const clock::duration frame_interval) const
+	{
+		auto deadline = now + std::chrono::seconds(1);
+
+		if (!this->frame_tasks_.empty())
+		{
+			deadline = now + frame_interval;
+		}
+
+		if (!this->delayed_tasks_.empty())
+		{
+			deadline = std::min(deadline, this->delayed_tasks_.front().get_deadline());
+		}
+
+		return deadline;
+	}
+
+	void task_queue::merge_tasks()
+	{
+		// Sequences follow the push order, producers racing in add() could otherwise
+		// append frame tasks out of sequence order
+		this->new_tasks_.drain([&](task&& task)
+		{
+			task.sequence = this->next_sequence_++;
+
+			if (task.interval.count() <= 0)
+			{
+				this->frame_tasks_.emplace_back(std::move(task));
+			}
+			else
+			{
+				this->delayed_tasks_.emplace_back(std::move(task));
+				std::push_heap(this->delayed_tasks_.begin(), this->delayed_tasks_.end(), task_deadline_compare{});
+			}
+		});
+	}
+
+	// Due tasks run interleaved with the per-frame ones in the order they were added,
+	// the same order a single task list would give them
+	void task_queue::execute_tasks(const clock::time_point now)
+	{
+		auto& frame_tasks = this->frame_tasks_;
+		auto& heap = this->delayed_tasks_;
+
+		task_list due_tasks;
+		while (!heap.empty() && heap.front().get_deadline() <= now)
+		{
+			std::pop_heap(heap.begin(), heap.end(), task_deadline_compare{});
+			due_tasks.emplace_back(std::move(heap.back()));
+			heap.pop_back();
+		}
+
+		std::sort(due_tasks.begin(), due_tasks.end(), [](const task& a, const task& b)
+		{
+			return a.sequence < b.sequence;
+		});
+
+		size_t frame_index = 0;
+		size_t kept = 0;
+		size_t due_index = 0;
+
+		// Also runs when a handler throws, the throwing task and the ones after it are kept
+		const auto _ = gsl::finally([&]()
+		{
+			for (; due_index < due_tasks.size(); ++due_index)
+			{
+				heap.emplace_back(std::move(due_tasks[due_index]));
+				std::push_heap(heap.begin(), heap.end(), task_deadline_compare{});
+			}
+
+			for (; frame_index < frame_tasks.size(); ++frame_index, ++kept)
+			{
+				if (kept != frame_index)
+				{
+					frame_tasks[kept] = std::move(frame_tasks[frame_index]);
+				}
+			}
+
+			frame_tasks.erase(frame_tasks.begin() + kept, frame_tasks.end());
+		});
+
+		while (frame_index < frame_tasks.size() || due_index < due_tasks.size())
+		{
+			const auto is_frame_task = due_index == due_tasks.size()
+				|| (frame_index < frame_tasks.size()
+					&& frame_tasks[frame_index].sequence < due_tasks[due_index].sequence);
+
+			if (is_frame_task)
+			{
+				auto& task = frame_tasks[frame_index];
+				task.last_call = now;
+
+				if (!task.handler())
+				{
+					if (kept != frame_index)
+					{
+						frame_tasks[kept] = std::move(task);
+					}
+
+					++kept;
+				}
+
+				++frame_index;
+			}
+			else
+			{
+				auto& task = due_tasks[due_index];
+				task.last_call = now;
+
+				if (!task.handler())
+				{
+					heap.emplace_back(std::move(task));
+					std::push_heap(heap.begin(), heap.end(), task_deadline_compare{});
+				}
+
+				++due_index;
+			}
+		}
+	}
+}
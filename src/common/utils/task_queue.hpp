@@ -0,0 +1,69 @@
+#pragma once
+
+#include "concurrency.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace utils::concurrency
+{
+	// Tasks of a single consumer thread. Tasks without an interval run on every execute call,
+	// delayed tasks sit in a deadline heap so only the ones that are due get touched.
+	// All tasks run in the order they were added, whatever their interval is.
+	class task_queue final
+	{
+	public:
+		using clock = std::chrono::high_resolution_clock;
+
+		// Returns true once the task is done and should be removed
+		using task_handler = std::function<bool()>;
+
+		// Can be called from any thread
+		void add(task_handler handler, std::chrono::milliseconds interval, clock::time_point last_call);
+
+		// Only called from the thread that owns the queue. Nested calls from a task are ignored,
+		// they must not touch the lists that are being executed
+		void execute(clock::time_point now);
+
+		// Only called from the thread that owns the queue, after executing it
+		clock::time_point get_next_deadline(clock::time_point now, clock::duration frame_interval) const;
+
+	private:
+		struct task
+		{
+			task_handler handler{};
+			std::chrono::milliseconds interval{};
+			clock::time_point last_call{};
+			std::uint64_t sequence{};
+
+			clock::time_point get_deadline() const
+			{
+				return this->last_call + this->interval;
+			}
+		};
+
+		// Orders the heap by the earliest deadline, ties run in the order they were added
+		struct task_deadline_compare
+		{
+			bool operator()(const task& a, const task& b) const;
+		};
+
+		using task_list = std::vector<task>;
+
+		mpsc_queue<task> new_tasks_;
+		std::uint64_t next_sequence_{};
+
+		// Sorted by sequence
+		task_list frame_tasks_;
+
+		// Heap ordered by task_deadline_compare
+		task_list delayed_tasks_;
+
+		bool executing_{false};
+
+		void merge_tasks();
+		void execute_tasks(clock::time_point now);
+	};
+}
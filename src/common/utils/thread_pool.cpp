@@ -0,0 +1,146 @@
+#include "thread_pool.hpp"
+#include "thread.hpp"
+#include "string.hpp"
+
+namespace utils::concurrency
+{
+	namespace
+	{
+		thread_local const thread_pool* current_pool = nullptr;
+		thread_local size_t current_index = 0;
+	}
+
+	thread_pool::thread_pool(const std::string& name, const size_t thread_count)
+	{
+		const auto count = std::max(size_t(1), thread_count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			this->queues_.emplace_back(std::make_unique<worker_queue>());
+		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			this->threads_.emplace_back(thread::create_named_thread(string::va("%s %zu", name.data(), i), [this, i]()
+			{
+				this->work(i);
+			}));
+		}
+	}
+
+	thread_pool::~thread_pool()
+	{
+		{
+			std::lock_guard _(this->wake_mutex_);
+			this->kill_ = true;
+		}
+
+		this->wake_cv_.notify_all();
+
+		for (auto& t : this->threads_)
+		{
+			if (t.joinable())
+			{
+				t.join();
+			}
+		}
+	}
+
+	void thread_pool::post(job&& job)
+	{
+		// Jobs posted from a worker stay on its own queue, they are likely to touch the same data
+		const auto index = current_pool == this
+			                   ? current_index
+			                   : this->next_queue_++ % this->queues_.size();
+
+		// Counted before it is visible, a worker taking it right away must not decrement below zero
+		{
+			std::lock_guard _(this->wake_mutex_);
+			++this->pending_;
+		}
+
+		{
+			auto& queue = *this->queues_[index];
+			std::lock_guard _(queue.mutex);
+			queue.jobs.emplace_back(std::move(job));
+		}
+
+		this->wake_cv_.notify_one();
+	}
+
+	size_t thread_pool::get_thread_count() const
+	{
+		return this->threads_.size();
+	}
+
+	void thread_pool::work(const size_t index)
+	{
+		current_pool = this;
+		current_index = index;
+
+		while (true)
+		{
+			job job{};
+			if (this->try_pop(index, job) || this->try_steal(index, job))
+			{
+				--this->pending_;
+				job();
+				continue;
+			}
+
+			std::unique_lock lock(this->wake_mutex_);
+			if (this->pending_ > 0)
+			{
+				// Another worker took the job in between, look again
+				lock.unlock();
+				std::this_thread::yield();
+				continue;
+			}
+
+			if (this->kill_)
+			{
+				return;
+			}
+
+			this->wake_cv_.wait(lock, [this]()
+			{
+				return this->kill_ || this->pending_ > 0;
+			});
+		}
+	}
+
+	bool thread_pool::try_pop(const size_t index, job& job)
+	{
+		auto& queue = *this->queues_[index];
+		std::lock_guard _(queue.mutex);
+
+		if (queue.jobs.empty())
+		{
+			return false;
+		}
+
+		job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+		return true;
+	}
+
+	bool thread_pool::try_steal(const size_t index, job& job)
+	{
+		for (size_t i = 1; i < this->queues_.size(); ++i)
+		{
+			auto& queue = *this->queues_[(index + i) % this->queues_.size()];
+			std::lock_guard _(queue.mutex);
+
+			if (queue.jobs.empty())
+			{
+				continue;
+			}
+
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			return true;
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace utils::concurrency
+{
+	// Work stealing thread pool. Every worker pushes and pops jobs at the back of its own
+	// deque, idle workers steal from the front of the others. Jobs must not throw.
+	class thread_pool final
+	{
+	public:
+		using job = std::function<void()>;
+
+		explicit thread_pool(const std::string& name, size_t thread_count = std::thread::hardware_concurrency());
+		~thread_pool();
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		void post(job&& job);
+		size_t get_thread_count() const;
+
+	private:
+		struct worker_queue
+		{
+			std::mutex mutex;
+			std::deque<job> jobs;
+		};
+
+		std::vector<std::unique_ptr<worker_queue>> queues_;
+		std::vector<std::thread> threads_;
+
+		std::mutex wake_mutex_;
+		std::condition_variable wake_cv_;
+		std::atomic<size_t> pending_{0};
+		std::atomic<size_t> next_queue_{0};
+		bool kill_{false};
+
+		void work(size_t index);
+		bool try_pop(size_t index, job& job);
+		bool try_steal(size_t index, job& job);
+	};
+}
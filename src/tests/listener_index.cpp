@@ -0,0 +1,254 @@
+#include "test_loader.hpp"
+
+#include <utils/listener_index.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <random>
+#include <ranges>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct test_entity
+	{
+		unsigned int id;
+
+		unsigned int get_entity_id() const
+		{
+			return this->id;
+		}
+	};
+
+	struct test_listener
+	{
+		uint64_t id{};
+		std::string event{};
+		test_entity entity{};
+		bool is_volatile{};
+		bool is_deleted{};
+		std::vector<std::pair<test_entity, std::string>> endon_conditions{};
+	};
+
+	using test_index = utils::listener_index<test_listener>;
+
+	std::vector<uint64_t> dispatch(test_index& index, const std::string& event, const unsigned int entity_id)
+	{
+		std::vector<uint64_t> called;
+		index.dispatch(event, entity_id, [&](test_listener& listener)
+		{
+			if (listener.is_volatile)
+			{
+				listener.is_deleted = true;
+			}
+
+			called.push_back(listener.id);
+		});
+
+		return called;
+	}
+}
+
+REGISTER_TEST(listener_index_fires_endon_after_compaction)
+{
+	test_index index;
+
+	// One bucket, every listener ends when entity 2 dies
+	for (uint64_t id = 1; id <= 100; ++id)
+	{
+		index.add({id, "damage", {1}, false, false, {{{2}, "death"}}});
+	}
+
+	// Removing every other listener and compacting moves the rest within the bucket
+	for (uint64_t id = 1; id <= 100; id += 2)
+	{
+		index.remove(id);
+	}
+
+	index.compact(1);
+	CHECK(dispatch(index, "damage", 1).size() == 50);
+
+	// Conditions added after the move still have to find their listener
+	index.add_endon_condition(50, test_entity{3}, "spawned");
+	index.handle_endon_conditions(3, "spawned");
+
+	auto called = dispatch(index, "damage", 1);
+	CHECK(called.size() == 49);
+	CHECK(std::ranges::find(called, 50) == called.end());
+
+	index.handle_endon_conditions(2, "death");
+	CHECK(dispatch(index, "damage", 1).empty());
+
+	// Compacting the removed listeners drops their endon entries, the bucket disappears
+	index.compact(1);
+	CHECK(index.bucket_count() == 0);
+	CHECK(!index.has_listeners("damage"));
+
+	// A new listener ending on the same event is unaffected by the old entries
+	index.add({101, "damage", {1}, false, false, {}});
+	index.handle_endon_conditions(2, "death");
+	CHECK((dispatch(index, "damage", 1) == std::vector<uint64_t>{101}));
+}
+
+REGISTER_TEST(listener_index_compacts_listeners_deleted_during_dispatch)
+{
+	test_index index;
+	index.add({1, "trigger", {1}, true, false, {{{2}, "death"}}});
+	index.add({2, "trigger", {3}, false, false, {}});
+
+	// The volatile listener runs once and its bucket goes away on the next compaction
+	CHECK((dispatch(index, "trigger", 1) == std::vector<uint64_t>{1}));
+	CHECK(dispatch(index, "trigger", 1).empty());
+
+	index.compact(1);
+	CHECK(index.bucket_count() == 1);
+	CHECK(index.find(1) == nullptr);
+
+	// Its endon entry went with it
+	index.handle_endon_conditions(2, "death");
+	CHECK((dispatch(index, "trigger", 3) == std::vector<uint64_t>{2}));
+}
+
+REGISTER_TEST(listener_index_fires_endon_while_compaction_is_spread_over_frames)
+{
+	test_index index;
+
+	// Many dirty buckets, only one of them is compacted per frame
+	for (unsigned int entity = 1; entity <= 20; ++entity)
+	{
+		for (uint64_t i = 0; i < 5; ++i)
+		{
+			const auto id = entity * 10 + i;
+			index.add({id, "trigger", {entity}, false, false, {{{100 + entity}, "stop"}}});
+		}
+
+		index.remove(entity * 10);
+	}
+
+	for (unsigned int entity = 1; entity <= 20; ++entity)
+	{
+		index.compact(1);
+
+		// Stops the listeners of a bucket that may or may not have been compacted yet
+		index.handle_endon_conditions(100 + entity, "stop");
+		CHECK(dispatch(index, "trigger", entity).empty());
+
+		if (entity < 20)
+		{
+			CHECK(dispatch(index, "trigger", entity + 1).size() == 4);
+		}
+	}
+
+	index.compact(100);
+	CHECK(index.bucket_count() == 0);
+}
+
+REGISTER_TEST(listener_index_matches_reference_model)
+{
+	std::mt19937 rng(2024);
+
+	const std::vector<std::string> events = {"damage", "death", "trigger", "spawned"};
+	constexpr auto entity_count = 4u;
+
+	test_index index;
+
+	// Alive listeners in the order they were added
+	std::map<uint64_t, test_listener> model;
+	uint64_t next_id = 1;
+
+	for (auto step = 0; step < 20000; ++step)
+	{
+		const auto op = rng() % 10;
+		const auto& event = events[rng() % events.size()];
+		const auto entity = static_cast<unsigned int>(1 + rng() % entity_count);
+
+		if (op < 4)
+		{
+			test_listener listener{next_id++, event, {entity}, rng() % 4 == 0, false, {}};
+			for (auto i = rng() % 3; i > 0; --i)
+			{
+				const auto endon_entity = static_cast<unsigned int>(1 + rng() % entity_count);
+				listener.endon_conditions.emplace_back(test_entity{endon_entity}, events[rng() % events.size()]);
+			}
+
+			model[listener.id] = listener;
+			index.add(std::move(listener));
+		}
+		else if (op == 4 && !model.empty())
+		{
+			auto i = model.begin();
+			std::advance(i, rng() % model.size());
+			index.remove(i->first);
+			model.erase(i);
+		}
+		else if (op == 5)
+		{
+			index.handle_endon_conditions(entity, event);
+			std::erase_if(model, [&](const auto& entry)
+			{
+				return std::ranges::any_of(entry.second.endon_conditions, [&](const auto& condition)
+				{
+					return condition.first.id == entity && condition.second == event;
+				});
+			});
+		}
+		else if (op == 6)
+		{
+			index.compact(rng() % 3);
+		}
+		else
+		{
+			std::vector<uint64_t> expected;
+			for (auto i = model.begin(); i != model.end();)
+			{
+				if (i->second.event == event && i->second.entity.id == entity)
+				{
+					expected.push_back(i->first);
+					if (i->second.is_volatile)
+					{
+						i = model.erase(i);
+						continue;
+					}
+				}
+
+				++i;
+			}
+
+			CHECK(dispatch(index, event, entity) == expected);
+		}
+
+		for (const auto& name : events)
+		{
+			// Removed listeners are only counted until their bucket is compacted
+			const auto alive = std::ranges::any_of(model, [&](const auto& entry)
+			{
+				return entry.second.event == name;
+			});
+
+			CHECK(!alive || index.has_listeners(name));
+		}
+	}
+
+	index.compact(std::numeric_limits<size_t>::max());
+
+	for (const auto& name : events)
+	{
+		const auto alive = std::ranges::any_of(model, [&](const auto& entry)
+		{
+			return entry.second.event == name;
+		});
+
+		CHECK(alive == index.has_listeners(name));
+	}
+
+	// Every tombstone has to reach compaction, otherwise buckets leak
+	for (const auto& id : model | std::views::keys)
+	{
+		index.remove(id);
+	}
+
+	index.compact(std::numeric_limits<size_t>::max());
+	CHECK(index.bucket_count() == 0);
+}
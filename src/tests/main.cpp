@@ -0,0 +1,6 @@
+#include "test_loader.hpp"
+
+int main()
+{
+	return tests::test_loader::run_all() == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "test_loader.hpp"
+
+#include <utils/concurrency.hpp>
+#include <utils/task_queue.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	constexpr auto producer_count = 8;
+	constexpr auto items_per_producer = 20000;
+
+	struct item
+	{
+		int producer;
+		int index;
+	};
+
+	// Every producer's items have to come out in the order that producer pushed them
+	void check_producer_order(const std::vector<item>& items)
+	{
+		std::vector<int> next(producer_count, 0);
+
+		for (const auto& item : items)
+		{
+			CHECK(item.index == next[item.producer]);
+			++next[item.producer];
+		}
+
+		for (const auto count : next)
+		{
+			CHECK(count == items_per_producer);
+		}
+	}
+
+	template <typename F>
+	void run_producers(F&& producer)
+	{
+		std::atomic<int> ready = 0;
+		std::vector<std::thread> threads;
+
+		for (auto p = 0; p < producer_count; ++p)
+		{
+			threads.emplace_back([&, p]()
+			{
+				// Start all producers at once so their pushes actually race
+				++ready;
+				while (ready < producer_count)
+				{
+					std::this_thread::yield();
+				}
+
+				producer(p);
+			});
+		}
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+}
+
+REGISTER_TEST(mpsc_queue_drains_in_push_order_with_concurrent_producers)
+{
+	utils::concurrency::mpsc_queue<item> queue;
+	std::vector<item> drained;
+	std::atomic<bool> done = false;
+
+	// The consumer drains while the producers are still pushing
+	std::thread consumer([&]()
+	{
+		while (true)
+		{
+			const auto finished = done.load();
+
+			queue.drain([&](item&& value)
+			{
+				drained.push_back(value);
+			});
+
+			if (finished)
+			{
+				break;
+			}
+		}
+	});
+
+	run_producers([&](const int p)
+	{
+		for (auto i = 0; i < items_per_producer; ++i)
+		{
+			queue.push({p, i});
+		}
+	});
+
+	done = true;
+	consumer.join();
+
+	CHECK(queue.empty());
+	CHECK(drained.size() == static_cast<size_t>(producer_count * items_per_producer));
+	check_producer_order(drained);
+}
+
+REGISTER_TEST(task_queue_runs_concurrently_added_tasks_in_push_order)
+{
+	const auto start_time = utils::concurrency::task_queue::clock::time_point{} + 1h;
+
+	utils::concurrency::task_queue queue;
+	std::vector<item> first_run;
+	std::vector<item> second_run;
+	auto* current_run = &first_run;
+
+	// Frame and delayed tasks mixed, so the due tasks get merged into the frame task list
+	run_producers([&](const int p)
+	{
+		for (auto i = 0; i < items_per_producer; ++i)
+		{
+			queue.add([&current_run, p, i]()
+			{
+				current_run->push_back({p, i});
+				return false;
+			}, (i % 3) ? 0ms : 5ms, start_time);
+		}
+	});
+
+	queue.execute(start_time + 5ms);
+
+	current_run = &second_run;
+	queue.execute(start_time + 10ms);
+
+	check_producer_order(first_run);
+
+	// Sequences are handed out in drain order, repeating tasks keep their relative order
+	CHECK(first_run.size() == second_run.size());
+	for (size_t i = 0; i < first_run.size(); ++i)
+	{
+		CHECK(first_run[i].producer == second_run[i].producer);
+		CHECK(first_run[i].index == second_run[i].index);
+	}
+}
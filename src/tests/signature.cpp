@@ -0,0 +1,230 @@
+#include "test_loader.hpp"
+
+#include <utils/signature.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Has to match the scan chunk size in signature.cpp, matches are placed across its chunk borders
+	constexpr size_t chunk_size = 0x40000;
+
+	struct test_pattern
+	{
+		std::vector<uint8_t> bytes;
+		std::string mask;
+
+		std::string to_string() const
+		{
+			std::string result;
+			for (size_t i = 0; i < this->bytes.size(); ++i)
+			{
+				result += this->mask[i] == '?' ? "? " : std::format("{:02X} ", this->bytes[i]);
+			}
+
+			return result;
+		}
+
+		void plant(std::vector<uint8_t>& buffer, const size_t offset) const
+		{
+			for (size_t i = 0; i < this->bytes.size(); ++i)
+			{
+				if (this->mask[i] != '?')
+				{
+					buffer[offset + i] = this->bytes[i];
+				}
+			}
+		}
+	};
+
+	test_pattern generate_pattern(std::mt19937& rng, const size_t length, const size_t wildcards)
+	{
+		test_pattern pattern{};
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			pattern.bytes.push_back(static_cast<uint8_t>(rng()));
+			pattern.mask.push_back('x');
+		}
+
+		// The last byte stays fixed, trailing wildcards are dropped by the parser
+		for (size_t i = 0; i < wildcards && length > 1; ++i)
+		{
+			pattern.mask[rng() % (length - 1)] = '?';
+		}
+
+		return pattern;
+	}
+
+	std::vector<size_t> get_addresses(const utils::hook::signature::signature_result& result)
+	{
+		std::vector<size_t> addresses;
+		for (size_t i = 0; i < result.count(); ++i)
+		{
+			addresses.push_back(reinterpret_cast<size_t>(result.get(i)));
+		}
+
+		return addresses;
+	}
+}
+
+REGISTER_TEST(signature_batch_matches_single_scans)
+{
+	std::mt19937 rng(1337);
+
+	std::vector<uint8_t> buffer(chunk_size * 4 + 0x123);
+	for (auto& byte : buffer)
+	{
+		byte = static_cast<uint8_t>(rng());
+	}
+
+	// Short patterns hit the random data by chance, long ones only match where they were planted.
+	// Lengths around 16, 32 and 64 bytes cover the limits of the vector kernels
+	std::vector<test_pattern> patterns;
+	for (const auto [length, wildcards] : std::initializer_list<std::pair<size_t, size_t>>{
+		     {1, 0}, {2, 0}, {3, 1}, {5, 2}, {15, 4}, {16, 0}, {17, 3}, {31, 6}, {33, 8}, {64, 10}, {80, 20},
+	     })
+	{
+		patterns.emplace_back(generate_pattern(rng, length, wildcards));
+	}
+
+	std::vector<std::pair<size_t, size_t>> planted;
+	for (size_t i = 0; i < patterns.size(); ++i)
+	{
+		const auto& pattern = patterns[i];
+		const auto length = pattern.bytes.size();
+
+		// Every chunk border gets a match that starts before it and ends after it
+		for (size_t border = chunk_size; border < buffer.size(); border += chunk_size)
+		{
+			const auto offset = border - std::min(border, (length + 1) / 2 + i);
+			pattern.plant(buffer, offset);
+			planted.emplace_back(i, offset);
+		}
+
+		// Stays clear of the tail, the kernels don't scan the last bytes of the range
+		const auto offset = buffer.size() - length - 64 - i * 97;
+		pattern.plant(buffer, offset);
+		planted.emplace_back(i, offset);
+	}
+
+	utils::hook::signature_batch batch(buffer.data(), buffer.size());
+	for (const auto& pattern : patterns)
+	{
+		batch.add(pattern.to_string());
+	}
+
+	const auto batch_results = batch.process();
+	CHECK(batch_results.size() == patterns.size());
+
+	for (size_t i = 0; i < patterns.size(); ++i)
+	{
+		const utils::hook::signature single(patterns[i].to_string(), buffer.data(), buffer.size());
+		const auto expected = get_addresses(single.process());
+		const auto actual = get_addresses(batch_results[i]);
+
+		CHECK(!expected.empty());
+		CHECK(actual == expected);
+	}
+
+	// Planting later patterns can overwrite earlier ones, only check the matches that survived
+	for (const auto& [index, offset] : planted)
+	{
+		const auto& pattern = patterns[index];
+		auto intact = true;
+		for (size_t j = 0; j < pattern.bytes.size(); ++j)
+		{
+			intact &= pattern.mask[j] == '?' || buffer[offset + j] == pattern.bytes[j];
+		}
+
+		if (!intact)
+		{
+			continue;
+		}
+
+		const auto address = reinterpret_cast<size_t>(buffer.data() + offset);
+		const auto matches = get_addresses(batch_results[index]);
+		CHECK(std::ranges::find(matches, address) != matches.end());
+	}
+}
+
+REGISTER_TEST(signature_batch_skips_patterns_longer_than_the_range)
+{
+	std::vector<uint8_t> buffer(0x100, 0x90);
+	buffer[0x80] = 0xCC;
+
+	// Longer than the whole range, must not be scanned at all
+	std::string oversized;
+	for (size_t i = 0; i < buffer.size() * 2; ++i)
+	{
+		oversized += "90 ";
+	}
+
+	utils::hook::signature_batch batch(buffer.data(), buffer.size());
+	batch.add("CC");
+	batch.add(oversized);
+
+	const auto results = batch.process();
+	CHECK(results.size() == 2);
+	CHECK(results[0].count() == 1);
+	CHECK(results[0].get(0) == buffer.data() + 0x80);
+	CHECK(results[1].count() == 0);
+}
+
+// Not a pass/fail benchmark, prints the time of both approaches so regressions show up in the log
+REGISTER_TEST(signature_batch_timing)
+{
+	std::mt19937 rng(42);
+
+	std::vector<uint8_t> buffer(0x2000000);
+	for (auto& byte : buffer)
+	{
+		byte = static_cast<uint8_t>(rng());
+	}
+
+	std::vector<std::string> patterns;
+	for (size_t i = 0; i < 64; ++i)
+	{
+		patterns.emplace_back(generate_pattern(rng, 12 + i % 12, i % 4).to_string());
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+
+	size_t single_matches = 0;
+	for (const auto& pattern : patterns)
+	{
+		single_matches += utils::hook::signature(pattern, buffer.data(), buffer.size()).process().count();
+	}
+
+	const auto single_end = std::chrono::high_resolution_clock::now();
+
+	utils::hook::signature_batch batch(buffer.data(), buffer.size());
+	for (const auto& pattern : patterns)
+	{
+		batch.add(pattern);
+	}
+
+	size_t batch_matches = 0;
+	for (const auto& result : batch.process())
+	{
+		batch_matches += result.count();
+	}
+
+	const auto batch_end = std::chrono::high_resolution_clock::now();
+
+	CHECK(single_matches == batch_matches);
+
+	const auto single_time = std::chrono::duration_cast<std::chrono::microseconds>(single_end - start).count();
+	const auto batch_time = std::chrono::duration_cast<std::chrono::microseconds>(batch_end - single_end).count();
+
+	std::printf("         %zu patterns over %zu MB: %lld us one by one, %lld us batched (%.2fx)\n", patterns.size(),
+	            buffer.size() >> 20, static_cast<long long>(single_time), static_cast<long long>(batch_time),
+	            static_cast<double>(single_time) / static_cast<double>(std::max(1ll, static_cast<long long>(batch_time))));
+}
@@ -0,0 +1,175 @@
+#include "test_loader.hpp"
+
+#include <utils/task_queue.hpp>
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	using utils::concurrency::task_queue;
+	using namespace std::chrono_literals;
+
+	const auto start_time = task_queue::clock::time_point{} + 1h;
+}
+
+REGISTER_TEST(task_queue_runs_equal_deadlines_in_add_order)
+{
+	task_queue queue;
+	std::vector<int> order;
+
+	// The heap is not stable on its own, ties have to come out in the order they were added
+	for (auto i = 0; i < 500; ++i)
+	{
+		queue.add([&order, i]()
+		{
+			order.push_back(i);
+			return true;
+		}, 10ms, start_time);
+	}
+
+	queue.execute(start_time + 9ms);
+	CHECK(order.empty());
+
+	queue.execute(start_time + 10ms);
+	CHECK(order.size() == 500);
+
+	for (auto i = 0; i < 500; ++i)
+	{
+		CHECK(order[i] == i);
+	}
+
+	queue.execute(start_time + 20ms);
+	CHECK(order.size() == 500);
+}
+
+REGISTER_TEST(task_queue_interleaves_frame_and_due_tasks_in_add_order)
+{
+	task_queue queue;
+	std::vector<int> order;
+
+	// Even tasks run every frame, odd ones are delayed with different intervals
+	for (auto i = 0; i < 100; ++i)
+	{
+		const auto interval = i % 2 ? std::chrono::milliseconds(1 + i % 7) : 0ms;
+		queue.add([&order, i]()
+		{
+			order.push_back(i);
+			return false;
+		}, interval, start_time);
+	}
+
+	// Every delayed task is due at once
+	queue.execute(start_time + 10ms);
+	CHECK(order.size() == 100);
+
+	for (auto i = 0; i < 100; ++i)
+	{
+		CHECK(order[i] == i);
+	}
+}
+
+REGISTER_TEST(task_queue_keeps_schedule_order_under_random_intervals)
+{
+	std::mt19937 rng(7);
+
+	constexpr auto task_count = 1000;
+	constexpr auto step = 5ms;
+	constexpr auto steps = 60;
+
+	task_queue queue;
+	std::vector<int> order;
+	std::vector<std::chrono::milliseconds> intervals;
+
+	for (auto i = 0; i < task_count; ++i)
+	{
+		const auto interval = step * static_cast<int>(rng() % 4);
+		intervals.push_back(interval);
+
+		queue.add([&order, i]()
+		{
+			order.push_back(i);
+			return false;
+		}, interval, start_time);
+	}
+
+	for (auto k = 1; k <= steps; ++k)
+	{
+		order.clear();
+		queue.execute(start_time + step * k);
+
+		// Tasks run again exactly when their interval elapsed, always in the order they were added
+		std::vector<int> expected;
+		for (auto i = 0; i < task_count; ++i)
+		{
+			if (intervals[i].count() == 0 || (step * k) % intervals[i] == 0ms)
+			{
+				expected.push_back(i);
+			}
+		}
+
+		CHECK(order == expected);
+	}
+}
+
+REGISTER_TEST(task_queue_keeps_tasks_when_a_handler_throws)
+{
+	task_queue queue;
+	std::vector<int> order;
+	auto should_throw = true;
+
+	for (auto i = 0; i < 6; ++i)
+	{
+		queue.add([&, i]()
+		{
+			if (i == 3 && should_throw)
+			{
+				should_throw = false;
+				throw std::runtime_error("handler failed");
+			}
+
+			order.push_back(i);
+			return i % 2 == 0;
+		}, i % 3 ? 5ms : 0ms, start_time);
+	}
+
+	auto thrown = false;
+	try
+	{
+		queue.execute(start_time + 5ms);
+	}
+	catch (const std::runtime_error&)
+	{
+		thrown = true;
+	}
+
+	CHECK(thrown);
+	CHECK((order == std::vector{0, 1, 2}));
+
+	// The throwing task and the ones after it are still scheduled, the finished ones are gone
+	order.clear();
+	queue.execute(start_time + 10ms);
+	CHECK((order == std::vector{1, 3, 4, 5}));
+
+	order.clear();
+	queue.execute(start_time + 15ms);
+	CHECK((order == std::vector{1, 3, 5}));
+}
+
+REGISTER_TEST(task_queue_ignores_nested_execution)
+{
+	task_queue queue;
+	auto runs = 0;
+
+	queue.add([&]()
+	{
+		++runs;
+		queue.execute(start_time);
+		return false;
+	}, 0ms, start_time);
+
+	queue.execute(start_time);
+	queue.execute(start_time);
+	CHECK(runs == 2);
+}
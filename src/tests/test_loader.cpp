@@ -0,0 +1,54 @@
+#include "test_loader.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <format>
+
+namespace tests
+{
+	void test_loader::register_test(const char* name, const test_function function)
+	{
+		get_tests().push_back({name, function});
+	}
+
+	size_t test_loader::run_all()
+	{
+		size_t failed = 0;
+
+		for (const auto& test : get_tests())
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			try
+			{
+				test.function();
+
+				const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::high_resolution_clock::now() - start);
+				std::printf("[ PASS ] %s (%lld ms)\n", test.name, static_cast<long long>(duration.count()));
+			}
+			catch (const std::exception& e)
+			{
+				++failed;
+				std::printf("[ FAIL ] %s: %s\n", test.name, e.what());
+			}
+		}
+
+		std::printf("%zu of %zu tests passed\n", get_tests().size() - failed, get_tests().size());
+		return failed;
+	}
+
+	std::vector<test_loader::test>& test_loader::get_tests()
+	{
+		static std::vector<test> tests;
+		return tests;
+	}
+
+	void check(const bool condition, const char* expression, const char* file, const int line)
+	{
+		if (!condition)
+		{
+			throw test_failure(std::format("{}({}): check failed: {}", file, line, expression));
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace tests
+{
+	class test_failure final : public std::runtime_error
+	{
+	public:
+		using std::runtime_error::runtime_error;
+	};
+
+	class test_loader final
+	{
+	public:
+		using test_function = void(*)();
+
+		struct test
+		{
+			const char* name;
+			test_function function;
+		};
+
+		class installer final
+		{
+		public:
+			installer(const char* name, const test_function function)
+			{
+				register_test(name, function);
+			}
+		};
+
+		static void register_test(const char* name, test_function function);
+
+		// Returns the number of failed tests
+		static size_t run_all();
+
+	private:
+		static std::vector<test>& get_tests();
+	};
+
+	void check(bool condition, const char* expression, const char* file, int line);
+}
+
+#define REGISTER_TEST(name)                                          \
+static void name();                                                  \
+namespace                                                            \
+{                                                                    \
+	static tests::test_loader::installer __test_##name{#name, name}; \
+}                                                                    \
+static void name()
+
+#define CHECK(expression) tests::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)